@@ -0,0 +1,224 @@
+// Бенчмарки горячего пути навигатора. Входные данные строятся из
+// фиксированного seed, поэтому одинаковы на любой машине.
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+
+#include "message_objects/BLE.h"
+#include "navigator/navigator.h"
+#include "navigator/solver.h"
+
+namespace {
+
+constexpr unsigned kSeed = 42;
+constexpr int kTxPower = -59;
+constexpr double kPathLossExponent = 3.0;
+
+// Истинное положение метки в данных бенчмарков
+constexpr double kTagX = 7.3;
+constexpr double kTagY = 4.1;
+
+/**
+ * Маяки на квадратной сетке с шагом 5 м
+ */
+std::vector<message_objects::BLEBeacon> makeBeacons(int count) {
+    std::vector<message_objects::BLEBeacon> beacons;
+    const int side = static_cast<int>(std::ceil(std::sqrt(count)));
+    for (int i = 0; i < count; ++i) {
+        beacons.push_back({"beacon-" + std::to_string(i), (i % side) * 5.0,
+                           (i / side) * 5.0});
+    }
+    return beacons;
+}
+
+int noisyRssi(const message_objects::BLEBeacon& beacon, std::mt19937& rng) {
+    std::normal_distribution<double> noise(0.0, 3.0);
+    const double d = std::max(0.5, std::hypot(beacon.x_ - kTagX, beacon.y_ - kTagY));
+    return static_cast<int>(std::lround(kTxPower - 10 * kPathLossExponent * std::log10(d) +
+                                        noise(rng)));
+}
+
+using Measurements =
+    std::vector<std::pair<std::string, std::vector<message_objects::BLEBeaconState>>>;
+
+Measurements makeMeasurements(const std::vector<message_objects::BLEBeacon>& beacons,
+                              int samples, std::mt19937& rng) {
+    Measurements measurements;
+    for (const auto& beacon : beacons) {
+        std::vector<message_objects::BLEBeaconState> states;
+        for (int s = 0; s < samples; ++s) {
+            states.push_back({beacon.name_, noisyRssi(beacon, rng), kTxPower});
+        }
+        measurements.emplace_back(beacon.name_, std::move(states));
+    }
+    return measurements;
+}
+
+void beaconArgs(benchmark::internal::Benchmark* b) {
+    for (int beacons : {3, 8, 32, 128}) {
+        for (int samples : {1, 4, 16, 64}) {
+            b->Args({beacons, samples});
+        }
+    }
+}
+
+void BM_RssiToDistance(benchmark::State& state) {
+    std::vector<int> rssi(1024);
+    std::mt19937 rng(kSeed);
+    std::uniform_int_distribution<int> dist(-100, -40);
+    for (auto& value : rssi) value = dist(rng);
+
+    for (auto _ : state) {
+        double sum = 0;
+        for (int value : rssi) sum += navigator::rssiToDistance(value, kTxPower);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * rssi.size());
+}
+BENCHMARK(BM_RssiToDistance);
+
+void BM_FilteredMedian(benchmark::State& state) {
+    const auto samples = static_cast<std::size_t>(state.range(0));
+    std::mt19937 rng(kSeed);
+    std::lognormal_distribution<double> dist(1.5, 0.4);
+    std::vector<double> source(samples);
+    for (auto& value : source) value = dist(rng);
+
+    std::vector<double> values;
+    for (auto _ : state) {
+        // копия входит в замер: filteredMedian сортирует на месте,
+        // а навигатор на каждом такте тоже работает со свежим вектором
+        values = source;
+        benchmark::DoNotOptimize(navigator::filteredMedian(values));
+    }
+    state.SetItemsProcessed(state.iterations() * samples);
+}
+BENCHMARK(BM_FilteredMedian)->RangeMultiplier(2)->Range(1, 64);
+
+void BM_Trilaterate(benchmark::State& state) {
+    const auto beacons = makeBeacons(static_cast<int>(state.range(0)));
+    std::mt19937 rng(kSeed);
+    std::vector<std::pair<message_objects::BLEBeacon, double>> distances;
+    for (const auto& beacon : beacons) {
+        distances.emplace_back(beacon, navigator::rssiToDistance(noisyRssi(beacon, rng), kTxPower));
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(navigator::trilaterate(distances));
+    }
+}
+BENCHMARK(BM_Trilaterate)->Arg(3)->Arg(8)->Arg(32)->Arg(128);
+
+void BM_CalculatePosition(benchmark::State& state) {
+    const auto beacons = makeBeacons(static_cast<int>(state.range(0)));
+    const int samples = static_cast<int>(state.range(1));
+    std::mt19937 rng(kSeed);
+    const auto source = makeMeasurements(beacons, samples, rng);
+
+    navigator::Navigator nav(beacons);
+    Measurements measurements;
+    for (auto _ : state) {
+        measurements = source;
+        benchmark::DoNotOptimize(nav.calculatePosition(measurements));
+    }
+    state.SetItemsProcessed(state.iterations() * beacons.size() * samples);
+}
+BENCHMARK(BM_CalculatePosition)->Apply(beaconArgs);
+
+// JSON объявления → группировка по маякам → позиция, как в MqttClient
+void BM_JsonToPosition(benchmark::State& state) {
+    const auto beacons = makeBeacons(static_cast<int>(state.range(0)));
+    const int samples = static_cast<int>(state.range(1));
+    std::mt19937 rng(kSeed);
+
+    std::vector<std::string> payloads;
+    for (const auto& [name, states] : makeMeasurements(beacons, samples, rng)) {
+        for (const auto& s : states) {
+            nlohmann::json json_data;
+            json_data["name"] = s.name_;
+            json_data["rssi"] = s.rssi_;
+            json_data["tx_power"] = s.txPower_;
+            payloads.push_back(json_data.dump());
+        }
+    }
+
+    navigator::Navigator nav(beacons);
+    for (auto _ : state) {
+        std::map<std::string, std::vector<message_objects::BLEBeaconState>> grouped;
+        for (const auto& payload : payloads) {
+            const auto json_data = nlohmann::json::parse(payload);
+            message_objects::BLEBeaconState s;
+            s.name_ = json_data["name"];
+            s.rssi_ = json_data["rssi"];
+            s.txPower_ = json_data["tx_power"];
+            grouped[s.name_].push_back(std::move(s));
+        }
+        Measurements measurements(std::make_move_iterator(grouped.begin()),
+                                  std::make_move_iterator(grouped.end()));
+        benchmark::DoNotOptimize(nav.calculatePosition(measurements));
+    }
+    state.SetItemsProcessed(state.iterations() * payloads.size());
+}
+BENCHMARK(BM_JsonToPosition)->Apply(beaconArgs);
+
+// Метка резко переносится на другой край площадки (пропуск отсчётов,
+// смена шлюза). Считаются такты до возврата ошибки под 1 м:
+// ограничение max_jump (range(0), 0 - выключено) не должно замораживать
+// сглаженные расстояния, а только растягивать сход на несколько тактов.
+void BM_JumpRecovery(benchmark::State& state) {
+    constexpr int kSettleTicks = 20;
+    constexpr int kMaxTicks = 200;
+    constexpr double kFromX = 1.0, kFromY = 1.0;
+    constexpr double kToX = 34.0, kToY = 34.0;
+    const auto beacons = makeBeacons(64);
+
+    navigator::NavigatorConfig config;
+    config.max_jump = double(state.range(0));
+    config.max_distance = 100.0;
+
+    auto tick = [&beacons](double x, double y, std::mt19937& rng) {
+        std::normal_distribution<double> noise(0.0, 3.0);
+        Measurements measurements;
+        for (const auto& beacon : beacons) {
+            const double d = std::max(0.5, std::hypot(beacon.x_ - x, beacon.y_ - y));
+            const int rssi = static_cast<int>(std::lround(
+                kTxPower - 10 * kPathLossExponent * std::log10(d) + noise(rng)));
+            measurements.emplace_back(
+                beacon.name_,
+                std::vector<message_objects::BLEBeaconState>{{beacon.name_, rssi, kTxPower}});
+        }
+        return measurements;
+    };
+
+    int recovery = kMaxTicks;
+    for (auto _ : state) {
+        std::mt19937 rng(kSeed);
+        navigator::Navigator nav(beacons, config);
+        for (int i = 0; i < kSettleTicks; ++i) {
+            auto measurements = tick(kFromX, kFromY, rng);
+            nav.calculatePosition(measurements);
+        }
+        recovery = kMaxTicks;
+        for (int i = 1; i <= kMaxTicks; ++i) {
+            auto measurements = tick(kToX, kToY, rng);
+            const auto [x, y] = nav.calculatePosition(measurements);
+            if (std::hypot(x - kToX, y - kToY) < 1.0) {
+                recovery = i;
+                break;
+            }
+        }
+    }
+    state.counters["recovery_ticks"] = recovery;
+}
+BENCHMARK(BM_JumpRecovery)->Arg(0)->Arg(1)->Arg(5);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,114 @@
+// Бенчмарки зон: обновление позиции метки против полного перебора
+// многоугольников. Комнаты - квадратная сетка 4x4 м с проходами 1 м.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "zones/zones.h"
+
+namespace {
+
+constexpr unsigned kSeed = 42;
+constexpr double kPitch = 5.0;
+
+std::vector<zones::Zone> makeRooms(int count) {
+    std::vector<zones::Zone> rooms;
+    const int side = static_cast<int>(std::ceil(std::sqrt(count)));
+    for (int i = 0; i < count; ++i) {
+        const double x = (i % side) * kPitch;
+        const double y = (i / side) * kPitch;
+        // восьмиугольник: рёбер больше, чем у прямоугольника
+        rooms.push_back({"room-" + std::to_string(i),
+                         {{x + 1, y}, {x + 3, y}, {x + 4, y + 1}, {x + 4, y + 3},
+                          {x + 3, y + 4}, {x + 1, y + 4}, {x, y + 3}, {x, y + 1}},
+                         30.0});
+    }
+    return rooms;
+}
+
+struct Walk {
+    std::vector<std::string> tags;
+    std::vector<std::pair<double, double>> positions;
+};
+
+// метки бродят по всей площади комнат
+Walk makeWalk(int tags, int rooms, int steps) {
+    const double side = std::ceil(std::sqrt(rooms)) * kPitch;
+    std::mt19937 rng(kSeed);
+    std::uniform_real_distribution<double> start(0.0, side);
+    std::normal_distribution<double> step(0.0, 0.7);
+    Walk walk;
+    std::vector<std::pair<double, double>> current(tags);
+    for (int t = 0; t < tags; ++t) {
+        walk.tags.push_back("tag-" + std::to_string(t));
+        current[t] = {start(rng), start(rng)};
+    }
+    for (int s = 0; s < steps; ++s) {
+        for (auto& [x, y] : current) {
+            x = std::clamp(x + step(rng), 0.0, side);
+            y = std::clamp(y + step(rng), 0.0, side);
+            walk.positions.emplace_back(x, y);
+        }
+    }
+    return walk;
+}
+
+// args: зон, меток
+void BM_ZoneUpdate(benchmark::State& state) {
+    const int rooms = static_cast<int>(state.range(0));
+    const int tags = static_cast<int>(state.range(1));
+    const Walk walk = makeWalk(tags, rooms, 64);
+
+    zones::ZoneEngine engine;
+    engine.setZones(makeRooms(rooms));
+    std::vector<zones::ZoneEvent> events;
+    std::size_t i = 0;
+    std::int64_t now_ms = 0;
+    for (auto _ : state) {
+        const auto& [x, y] = walk.positions[i];
+        engine.update(walk.tags[i % tags], x, y, now_ms, events);
+        events.clear();
+        if (++i == walk.positions.size()) i = 0;
+        now_ms += 10;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ZoneUpdate)
+    ->ArgsProduct({{16, 1024, 4096, 16384}, {100, 1000}});
+
+// то же без сетки: каждая позиция против каждой зоны
+void BM_ZoneNaive(benchmark::State& state) {
+    const int rooms = static_cast<int>(state.range(0));
+    const Walk walk = makeWalk(100, rooms, 64);
+    const zones::ZoneIndex index(makeRooms(rooms), {});
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto& [x, y] = walk.positions[i];
+        int inside = 0;
+        for (std::uint32_t zone = 0; zone < index.zones().size(); ++zone) {
+            inside += index.contains(zone, x, y);
+        }
+        benchmark::DoNotOptimize(inside);
+        if (++i == walk.positions.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ZoneNaive)->Arg(16)->Arg(1024)->Arg(4096)->Arg(16384);
+
+void BM_ZoneIndexBuild(benchmark::State& state) {
+    const auto rooms = makeRooms(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(zones::ZoneIndex(rooms, {}));
+    }
+}
+BENCHMARK(BM_ZoneIndexBuild)->Arg(1024)->Arg(16384);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,244 @@
+// bacond: приём объявлений маяков -> навигатор -> публикация позиций.
+// Без GUI, нужен только Qt Core.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QList>
+#include <QPair>
+#include <QPointF>
+
+#include <csignal>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+#include "config/config.h"
+#include "logging/log.h"
+#include "mqtt_connector/mqtt_client.h"
+#include "tracing/trace.h"
+
+namespace {
+
+using Settings = std::map<std::string, std::string>;
+
+std::string value(const Settings& settings, const std::string& key,
+                  const std::string& fallback) {
+    auto it = settings.find(key);
+    return it == settings.end() ? fallback : it->second;
+}
+
+int intValue(const Settings& settings, const std::string& key, int fallback) {
+    auto it = settings.find(key);
+    return it == settings.end() ? fallback : std::stoi(it->second);
+}
+
+double doubleValue(const Settings& settings, const std::string& key,
+                   double fallback) {
+    auto it = settings.find(key);
+    return it == settings.end() ? fallback : std::stod(it->second);
+}
+
+bool boolValue(const Settings& settings, const std::string& key,
+               bool fallback) {
+    auto it = settings.find(key);
+    if (it == settings.end()) return fallback;
+    return it->second == "true" || it->second == "1" || it->second == "yes";
+}
+
+mqtt_connector::ConnectionConfig connectionConfig(const Settings& settings) {
+    mqtt_connector::ConnectionConfig config;
+    config.broker_host = value(settings, "broker.host", config.broker_host);
+    config.broker_port = intValue(settings, "broker.port", config.broker_port);
+    config.client_id = value(
+        settings, "broker.client_id",
+        "bacond-" + std::to_string(QCoreApplication::applicationPid()));
+    config.keep_alive_interval =
+        intValue(settings, "broker.keep_alive", config.keep_alive_interval);
+    config.clean_session = boolValue(settings, "broker.clean_session", false);
+    config.use_ssl = boolValue(settings, "broker.ssl", config.use_ssl);
+    config.ingest_shards =
+        intValue(settings, "ingest.shards", config.ingest_shards);
+    config.shared_group =
+        value(settings, "ingest.shared_group", config.shared_group);
+    config.dedup_window_ms =
+        intValue(settings, "ingest.dedup_window_ms", config.dedup_window_ms);
+    return config;
+}
+
+mqtt_connector::PositionStreamOptions positionStream(const Settings& settings) {
+    mqtt_connector::PositionStreamOptions options;
+    options.enabled = boolValue(settings, "positions.enabled", true);
+    options.topic_prefix =
+        value(settings, "positions.topic", options.topic_prefix);
+    options.encoding = value(settings, "positions.encoding", "json") == "binary"
+                           ? mqtt_connector::PositionEncoding::BINARY
+                           : mqtt_connector::PositionEncoding::JSON;
+    options.qos = intValue(settings, "positions.qos", options.qos);
+    options.max_rate_hz =
+        doubleValue(settings, "positions.max_rate_hz", options.max_rate_hz);
+    options.min_delta =
+        doubleValue(settings, "positions.min_delta", options.min_delta);
+    return options;
+}
+
+mqtt_connector::ZoneStreamOptions zoneStream(const Settings& settings) {
+    mqtt_connector::ZoneStreamOptions options;
+    options.enabled = boolValue(settings, "zones.publish", true);
+    options.topic_prefix = value(settings, "zones.topic", options.topic_prefix);
+    options.qos = intValue(settings, "zones.qos", options.qos);
+    return options;
+}
+
+zones::ZoneOptions zoneOptions(const Settings& settings) {
+    zones::ZoneOptions options;
+    options.hysteresis_m =
+        doubleValue(settings, "zones.hysteresis_m", options.hysteresis_m);
+    options.confirm_updates =
+        intValue(settings, "zones.confirm", options.confirm_updates);
+    options.cell_size = doubleValue(settings, "zones.cell_size", options.cell_size);
+    return options;
+}
+
+navigator::NavigatorConfig navigatorConfig(const Settings& settings) {
+    navigator::NavigatorConfig config;
+    config.alpha = doubleValue(settings, "navigator.alpha", config.alpha);
+    config.position_alpha =
+        doubleValue(settings, "navigator.position_alpha", config.position_alpha);
+    config.max_jump = doubleValue(settings, "navigator.max_jump", config.max_jump);
+    config.max_distance =
+        doubleValue(settings, "navigator.max_distance", config.max_distance);
+    config.path_loss_exponent = doubleValue(settings, "navigator.path_loss_exponent",
+                                            config.path_loss_exponent);
+    return config;
+}
+
+logging::LogOptions logOptions(const Settings& settings) {
+    logging::LogOptions options;
+    const std::string level = value(settings, "log.level", "info");
+    if (!logging::parseLevel(level, options.level)) {
+        throw std::invalid_argument("Unknown log.level: " + level);
+    }
+    options.file = value(settings, "log.file", "");
+    options.burst_per_second =
+        intValue(settings, "log.burst_per_second", options.burst_per_second);
+    return options;
+}
+
+QList<QPair<QString, QPointF>> beacons(const std::string& path) {
+    QList<QPair<QString, QPointF>> result;
+    for (const auto& beacon : ConfigReader(path).readBeacons()) {
+        result.append({QString::fromStdString(beacon.name_),
+                       QPointF(beacon.x_, beacon.y_)});
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    // SIGINT/SIGTERM (и SIGUSR1 - дамп трассы) блокируются до запуска
+    // потоков и ждутся в отдельном потоке через sigwait: из обработчика
+    // сигнала Qt трогать нельзя
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    sigaddset(&stop_signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bacond");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless BLE positioning server");
+    parser.addHelpOption();
+    parser.addOption({{"c", "config"}, "Settings file (key = value).", "file",
+                      "bacond.conf"});
+    parser.process(app);
+
+    Settings settings;
+    QList<QPair<QString, QPointF>> known_beacons;
+    try {
+        settings = ConfigReader(parser.value("config").toStdString())
+                       .readSettings();
+        logging::configure(logOptions(settings));
+        known_beacons = beacons(value(settings, "beacons", "beacons.csv"));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    mqtt_connector::MqttClient client;
+    QObject::connect(&client, &mqtt_connector::MqttClient::setConnectStatus,
+                     [](const QString& status) {
+                         BACON_LOG_INFO("bacond", "broker status", "status",
+                                        status.toStdString());
+                     });
+    QObject::connect(&client, &mqtt_connector::MqttClient::zoneEvent,
+                     [](const QString& tag, const QString& zone, const QString& event,
+                        const QPointF&) {
+                         BACON_LOG_DEBUG("zones", "zone event", "event",
+                                         event.toStdString(), "tag", tag.toStdString(),
+                                         "zone", zone.toStdString());
+                     });
+
+    try {
+        client.setBeacons(known_beacons);
+        client.setFreqOnChange(
+            static_cast<float>(doubleValue(settings, "navigator.freq", 1.0)));
+        client.setNavigatorConfig(navigatorConfig(settings));
+        client.setPositionStream(positionStream(settings));
+        if (settings.count("zones.file")) {
+            auto zone_list = ConfigReader(value(settings, "zones.file", "")).readZones();
+            BACON_LOG_INFO("bacond", "zones loaded", "count", zone_list.size());
+            client.setZones(std::move(zone_list), zoneOptions(settings));
+            client.setZoneStream(zoneStream(settings));
+        }
+        if (settings.count("record.directory")) {
+            recorder::RecorderOptions record;
+            record.directory = value(settings, "record.directory", ".");
+            record.max_file_bytes =
+                static_cast<std::uint64_t>(intValue(settings, "record.max_file_mb", 256)) *
+                1024 * 1024;
+            record.max_file_seconds =
+                intValue(settings, "record.max_file_seconds", record.max_file_seconds);
+            client.startRecording(record);
+        }
+        tracing::setEnabled(boolValue(settings, "trace.enabled", false));
+        if (boolValue(settings, "metrics.enabled", true)) {
+            metrics::ExporterOptions exporter;
+            exporter.bind_address =
+                value(settings, "metrics.bind", exporter.bind_address);
+            exporter.port = intValue(settings, "metrics.port", exporter.port);
+            client.startMetricsExporter(exporter);
+        }
+        client.initialize(connectionConfig(settings));
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid settings: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const std::string trace_file = value(settings, "trace.file", "bacond-trace.json");
+    std::thread([&app, stop_signals, trace_file] {
+        int signal = 0;
+        while (sigwait(&stop_signals, &signal) == 0 && signal == SIGUSR1) {
+            if (tracing::dumpChromeTrace(trace_file)) {
+                BACON_LOG_INFO("bacond", "trace written", "file", trace_file);
+            } else {
+                BACON_LOG_ERROR("bacond", "cannot write trace", "file", trace_file);
+            }
+        }
+        QMetaObject::invokeMethod(&app, &QCoreApplication::quit,
+                                  Qt::QueuedConnection);
+    }).detach();
+
+    const int code = QCoreApplication::exec();
+    client.shutdown();
+    logging::flush();
+    return code;
+}
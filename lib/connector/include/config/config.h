@@ -1,9 +1,11 @@
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 
 #include "message_objects/BLE.h" // здесь у тебя объявлен struct BLEBeacon
+#include "zones/zones.h"
 
 class ConfigReader {
 public:
@@ -12,6 +14,13 @@ public:
     // Читает конфиг и возвращает список маяков
     std::vector<message_objects::BLEBeacon> readBeacons() const;
 
+    // Читает зоны: строки "имя;dwell_s;x1,y1;x2,y2;x3,y3[;...]",
+    // dwell_s = 0 - без события пребывания; строки с # пропускаются
+    std::vector<zones::Zone> readZones() const;
+
+    // Читает настройки "ключ = значение", строки с # пропускаются
+    std::map<std::string, std::string> readSettings() const;
+
 private:
     std::string filePath_;
 };
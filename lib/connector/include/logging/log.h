@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Нижний уровень, попадающий в сборку: вызовы ниже него не генерируют кода.
+ * 0 - trace, 1 - debug, 2 - info, 3 - warn, 4 - error (CMake: BACON_LOG_LEVEL)
+ */
+#ifndef BACON_LOG_MIN_LEVEL
+#define BACON_LOG_MIN_LEVEL 1
+#endif
+
+namespace logging {
+
+enum class Level : int { TRACE = 0, DEBUG = 1, INFO = 2, WARN = 3, ERROR = 4 };
+
+const char* levelName(Level level);
+
+/**
+ * Разбор "trace" / "debug" / "info" / "warn" / "error"
+ * @return false если имя неизвестно
+ */
+bool parseLevel(std::string_view name, Level& level);
+
+struct LogOptions {
+    Level level = Level::INFO;      // порог во время работы (не ниже собранного)
+    std::string file;               // пусто - stderr
+    int flush_interval_ms = 20;     // период опроса буферов потоком вывода
+    int burst_per_second = 20;      // строк в секунду с одного места вызова
+};
+
+/**
+ * Настройка логгера; можно вызывать повторно
+ */
+void configure(const LogOptions& options);
+
+/**
+ * Дождаться вывода всего записанного к этому моменту
+ */
+void flush();
+
+/**
+ * Строк отброшено из-за переполнения буферов потоков
+ */
+std::uint64_t dropped();
+
+inline std::atomic<int> g_level{static_cast<int>(Level::INFO)};
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) >= g_level.load(std::memory_order_relaxed);
+}
+
+/**
+ * Ограничитель частоты одного места вызова: не больше burst строк
+ * в секунду; число отброшенных выводится полем suppressed= в первой
+ * строке следующей секунды
+ */
+class RateLimiter {
+   public:
+    bool acquire(std::int64_t now_ms, std::uint32_t& suppressed);
+
+   private:
+    std::atomic<std::int64_t> window_start_{0};
+    std::atomic<std::uint32_t> count_{0};
+    std::atomic<std::uint32_t> suppressed_{0};
+};
+
+/**
+ * Текст одной строки (сообщение и поля key=value) фиксированного размера:
+ * формируется в потоке вызова без аллокаций, длинное обрезается
+ */
+class LineWriter {
+   public:
+    static constexpr std::size_t kCapacity = 232;
+
+    void message(std::string_view text) {
+        append("msg=");
+        quoted(text, true);
+    }
+
+    template <typename T>
+    void field(std::string_view key, const T& value) {
+        append(" ");
+        append(key);
+        append("=");
+        write(value);
+    }
+
+    std::string_view view() const { return {data_, size_}; }
+
+   private:
+    char data_[kCapacity];
+    std::size_t size_ = 0;
+
+    void append(std::string_view text) {
+        const std::size_t n = std::min(text.size(), kCapacity - size_);
+        std::memcpy(data_ + size_, text.data(), n);
+        size_ += n;
+    }
+
+    // кавычки - если без них строку не разобрать (или always)
+    void quoted(std::string_view text, bool always = false);
+
+    void write(bool value) { append(value ? "true" : "false"); }
+
+    void write(const char* value) { quoted(value ? value : ""); }
+
+    void write(std::string_view value) { quoted(value); }
+
+    void write(const std::string& value) { quoted(value); }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void write(T value) {
+        auto [end, error] = std::to_chars(data_ + size_, data_ + kCapacity, value);
+        if (error == std::errc()) size_ = static_cast<std::size_t>(end - data_);
+    }
+};
+
+/**
+ * Постановка строки в буфер текущего потока; при переполнении строка
+ * отбрасывается, поток вызова никогда не ждёт вывода
+ */
+void submit(Level level, const char* component, std::int64_t timestamp_us,
+            const LineWriter& line);
+
+std::int64_t nowMicros();
+
+template <typename... Args>
+void write(RateLimiter& limiter, Level level, const char* component,
+           std::string_view message, const Args&... fields) {
+    static_assert(sizeof...(Args) % 2 == 0, "fields are key, value pairs");
+    const std::int64_t now = nowMicros();
+    std::uint32_t suppressed = 0;
+    if (!limiter.acquire(now / 1000, suppressed)) return;
+
+    LineWriter line;
+    line.message(message);
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        [[maybe_unused]] const auto args = std::tie(fields...);
+        (line.field(std::get<2 * I>(args), std::get<2 * I + 1>(args)), ...);
+    }(std::make_index_sequence<sizeof...(Args) / 2>());
+    if (suppressed) line.field("suppressed", suppressed);
+    submit(level, component, now, line);
+}
+
+}  // namespace logging
+
+/**
+ * BACON_LOG_WARN("mqtt", "JSON parsing error", "error", e.what());
+ * После компонента и сообщения - пары ключ, значение.
+ */
+#define BACON_LOG(level, component, message, ...)                             \
+    do {                                                                      \
+        if constexpr (static_cast<int>(level) >= BACON_LOG_MIN_LEVEL) {       \
+            if (::logging::enabled(level)) {                                  \
+                static ::logging::RateLimiter bacon_log_limiter;              \
+                ::logging::write(bacon_log_limiter, level, component,         \
+                                 message __VA_OPT__(, ) __VA_ARGS__);         \
+            }                                                                 \
+        }                                                                     \
+    } while (false)
+
+#define BACON_LOG_TRACE(...) BACON_LOG(::logging::Level::TRACE, __VA_ARGS__)
+#define BACON_LOG_DEBUG(...) BACON_LOG(::logging::Level::DEBUG, __VA_ARGS__)
+#define BACON_LOG_INFO(...) BACON_LOG(::logging::Level::INFO, __VA_ARGS__)
+#define BACON_LOG_WARN(...) BACON_LOG(::logging::Level::WARN, __VA_ARGS__)
+#define BACON_LOG_ERROR(...) BACON_LOG(::logging::Level::ERROR, __VA_ARGS__)
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace message_objects {
+    // Метка, если в сообщении нет поля "tag" (единственный esp)
+    inline constexpr char kDefaultTag[] = "esp";
+
     struct BLEBeacon {
         std::string name_;
         double x_;
@@ -13,5 +17,8 @@ namespace message_objects {
         std::string name_;
         int rssi_;
         int txPower_;
+        std::string tag_ = kDefaultTag;  // устройство, которое услышало маяк
+        std::string gateway_;            // шлюз, передавший объявление, "" - неизвестен
+        std::uint32_t seq_ = 0;          // номер объявления у метки, 0 - нет (без отсева копий)
     };
 }; // namespace message_objects
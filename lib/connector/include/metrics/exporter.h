@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "metrics/metrics.h"
+
+namespace metrics {
+
+struct ExporterOptions {
+    std::string bind_address = "127.0.0.1";  // 0.0.0.0 - все интерфейсы
+    int port = 9464;
+};
+
+/**
+ * Метрики реестра в текстовом формате Prometheus (exposition 0.0.4).
+ * Гистограммы выводятся корзинами по степеням двойки: le = 2^k - 1
+ */
+std::string formatPrometheus(const Registry& registry);
+
+/**
+ * Минимальный HTTP-сервер для сбора метрик: GET /metrics.
+ *
+ * Работает в собственном потоке и обслуживает запросы по одному; снимок
+ * читает атомики реестра, поэтому сбор не блокирует ни потоки Paho,
+ * ни поток обработки. Проверка: curl http://127.0.0.1:9464/metrics
+ */
+class Exporter {
+   public:
+    explicit Exporter(const Registry& registry,
+                      ExporterOptions options = ExporterOptions());
+    ~Exporter();
+
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+
+    /**
+     * Открытие сокета и запуск потока
+     * @return false если адрес занят или недоступен (причина - в логе)
+     */
+    bool start();
+
+    void stop();
+
+    bool isRunning() const { return thread_.joinable(); }
+
+    /**
+     * Дополнительный GET-путь (например, /trace); регистрируется до start()
+     * @param body Тело ответа, вызывается в потоке сервера
+     */
+    void addHandler(const std::string& path, const std::string& content_type,
+                    std::function<std::string()> body);
+
+    /**
+     * Фактический порт (при port = 0 его выбирает система)
+     */
+    int port() const { return bound_port_; }
+
+    std::uint64_t scrapes() const {
+        return scrapes_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    const Registry& registry_;
+    ExporterOptions options_;
+
+    int listen_fd_ = -1;
+    int wake_fds_[2] = {-1, -1};  // pipe: запись будит poll при остановке
+    int bound_port_ = 0;
+    std::thread thread_;
+    std::atomic<std::uint64_t> scrapes_{0};
+
+    struct Handler {
+        std::string content_type;
+        std::function<std::string()> body;
+    };
+    std::map<std::string, Handler> handlers_;
+
+    void serve();
+
+    void handle(int client_fd);
+
+    void closeSockets();
+};
+
+}  // namespace metrics
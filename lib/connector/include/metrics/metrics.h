@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace metrics {
+
+/**
+ * Метрики горячего пути.
+ *
+ * Запись - одна relaxed-операция над атомиком своего шарда: поток пишет
+ * в ячейку по номеру, выданному ему при первом обращении, поэтому потоки
+ * Paho и поток обработки не делят кэш-линии. Чтение суммирует шарды и
+ * не останавливает запись; значения согласованы с точностью до записей,
+ * идущих в момент чтения.
+ */
+
+inline constexpr std::size_t kShards = 16;
+
+/**
+ * Шард текущего потока: выдаются по кругу при первом обращении
+ */
+std::size_t threadShard();
+
+/**
+ * Монотонный счётчик
+ */
+class Counter {
+   public:
+    void add(std::uint64_t n = 1) {
+        cells_[threadShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const;
+
+   private:
+    struct alignas(64) Cell {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<Cell, kShards> cells_;
+};
+
+/**
+ * Мгновенное значение (глубина очереди, размер буфера)
+ */
+class Gauge {
+   public:
+    void set(std::int64_t value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    void add(std::int64_t delta) {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    std::int64_t value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    alignas(64) std::atomic<std::int64_t> value_{0};
+};
+
+/**
+ * Снимок гистограммы
+ */
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t max = 0;
+    // непустые корзины по возрастанию: {верхняя граница включительно, число}
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buckets;
+
+    double mean() const { return count ? double(sum) / double(count) : 0.0; }
+
+    /**
+     * Значение квантиля q (0..1): верхняя граница корзины, не больше max
+     */
+    std::uint64_t percentile(double q) const;
+};
+
+/**
+ * Гистограмма целых значений в log-linear корзинах, как в HdrHistogram:
+ * каждый интервал [2^m, 2^(m+1)) делится на kSubBuckets равных корзин,
+ * относительная погрешность - не больше 1/kSubBuckets. Значения от
+ * 2^kMaxBits попадают в отдельную последнюю корзину без верхней границы.
+ */
+class Histogram {
+   public:
+    static constexpr int kSubBits = 4;
+    static constexpr std::uint64_t kSubBuckets = 1u << kSubBits;
+    static constexpr int kMaxBits = 40;  // 2^40 нс - около 18 минут
+    // + корзина переполнения
+    static constexpr std::size_t kBuckets =
+        (kMaxBits - kSubBits + 1) * kSubBuckets + 1;
+    // корзин много, поэтому шардов меньше, чем у счётчика
+    static constexpr std::size_t kShards = 4;
+
+    static std::size_t bucketIndex(std::uint64_t value) {
+        if (value < kSubBuckets) return static_cast<std::size_t>(value);
+        const int msb = std::bit_width(value) - 1;
+        if (msb >= kMaxBits) return kBuckets - 1;
+        const int shift = msb - kSubBits;
+        return static_cast<std::size_t>(shift + 1) * kSubBuckets +
+               ((value >> shift) & (kSubBuckets - 1));
+    }
+
+    static std::uint64_t bucketUpperBound(std::size_t index);
+
+    void record(std::uint64_t value) {
+        Shard& shard = shards_[threadShard() % kShards];
+        shard.counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        auto max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(
+                                  max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot snapshot() const;
+
+   private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<std::uint64_t>, kBuckets> counts{};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> max{0};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+/**
+ * Снимок одной метрики для вывода (getStatus, экспорт)
+ */
+struct MetricSnapshot {
+    std::string name;
+    std::string help;
+    MetricType type = MetricType::COUNTER;
+    double value = 0;               // COUNTER, GAUGE
+    HistogramSnapshot histogram;    // HISTOGRAM
+};
+
+/**
+ * Реестр метрик. Регистрация берёт мьютекс и делается заранее, вне горячего
+ * пути; возвращённые ссылки живут, пока жив реестр. Повторная регистрация
+ * имени возвращает ту же метрику.
+ */
+class Registry {
+   public:
+    Counter& counter(const std::string& name, const std::string& help);
+
+    Gauge& gauge(const std::string& name, const std::string& help);
+
+    /**
+     * Вычисляемое значение: функция вызывается при каждом снимке.
+     * Повторная регистрация заменяет функцию; имя обычного gauge - ошибка
+     */
+    void gauge(const std::string& name, const std::string& help,
+               std::function<double()> read);
+
+    Histogram& histogram(const std::string& name, const std::string& help);
+
+    /**
+     * Снимок всех метрик в порядке регистрации
+     */
+    std::vector<MetricSnapshot> snapshot() const;
+
+    /**
+     * Текстовая сводка: по строке на метрику, для гистограмм -
+     * число, среднее, p50/p99 и максимум
+     */
+    std::string format(const std::string& indent = "  ") const;
+
+   private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        MetricType type;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::function<double()> read;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    Entry* find(const std::string& name, MetricType type);
+
+    mutable std::mutex mutex_;
+    std::deque<Entry> entries_;
+};
+
+}  // namespace metrics
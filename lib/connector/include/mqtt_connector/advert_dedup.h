@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "message_objects/BLE.h"
+
+namespace mqtt_connector {
+
+/**
+ * @brief Отсев копий одного объявления, пришедших от нескольких шлюзов.
+ *
+ * Объявление опознаётся по (метка, маяк, seq). Хеш-таблица с открытой
+ * адресацией хранит 64-битные отпечатки за последние window_ms: отпечаток
+ * объявления с номером такта, в очередь которого оно попало, и отпечаток
+ * копии (объявление + шлюз). Копии от разных шлюзов в пределах такта
+ * пропускаются и сливаются в одно измерение (fuseGatewayCopies); повтор от
+ * того же шлюза и копия, опоздавшая к уже обработанному такту, отбрасываются.
+ * При переполнении затираются самые старые записи - отсев ослабевает,
+ * память не растёт.
+ */
+class AdvertDeduplicator {
+   public:
+    enum class Verdict {
+        ACCEPT,     ///< Первая копия или копия от другого шлюза
+        DUPLICATE,  ///< Повтор от того же шлюза
+        LATE        ///< Объявление уже ушло в навигатор в прошлом такте
+    };
+
+    /**
+     * @param window_ms Сколько помнить объявление
+     * @param capacity Записей в таблице (округляется до степени двойки)
+     */
+    explicit AdvertDeduplicator(int window_ms = 500, std::size_t capacity = 1 << 16);
+
+    /**
+     * @brief Проверка и запоминание объявления; потокобезопасно
+     * @param generation Номер текущего такта обработки
+     * @param now_ms Время прихода, мс: clockMs() для живого трафика, время
+     * записи при воспроизведении - тогда вердикты не зависят от темпа
+     * Измерения без seq всегда принимаются.
+     */
+    Verdict check(const message_objects::BLEBeaconState& state, std::uint32_t generation,
+                  std::uint32_t now_ms);
+
+    /**
+     * @brief Монотонные часы отсева, мс с создания
+     */
+    std::uint32_t clockMs() const;
+
+    void clear();
+
+   private:
+    struct Entry {
+        std::uint64_t key = 0;         ///< 0 - свободна
+        std::uint32_t expires = 0;     ///< мс по часам check()
+        std::uint32_t generation = 0;
+    };
+
+    /**
+     * @brief Часть таблицы под своим мьютексом; обе записи объявления
+     * лежат в одной части, проверка берёт одну блокировку
+     */
+    struct Stripe {
+        std::mutex mutex;
+        std::vector<Entry> entries;
+    };
+
+    static constexpr std::size_t kStripes = 16;
+    static constexpr std::size_t kMaxProbe = 8;
+
+    std::uint32_t window_ms_;
+    std::size_t mask_;
+    const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    std::array<Stripe, kStripes> stripes_;
+
+    // под мьютексом части: найденная живая запись или слот для новой
+    Entry* find(Stripe& stripe, std::uint64_t key, std::uint32_t now, bool& found);
+};
+
+/**
+ * @brief Сливает копии одного объявления (равный ненулевой seq) в одно
+ * измерение: RSSI усредняется по мощности, порядок первых копий сохраняется
+ * @return Сколько измерений убрано
+ */
+std::size_t fuseGatewayCopies(std::vector<message_objects::BLEBeaconState>& states);
+
+}  // namespace mqtt_connector
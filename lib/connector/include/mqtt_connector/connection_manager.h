@@ -2,6 +2,9 @@
 
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <random>
 #include <thread>
 #include <mutex>
 
@@ -11,6 +14,10 @@
 namespace mqtt {
     class async_client;
     class callback;
+    class connect_options;
+    class iaction_listener;
+    class message;
+    class token;
 }
 
 // Forward declaration
@@ -29,9 +36,11 @@ public:
     ~ConnectionManager();
 
     /**
-     * @brief Подключение к MQTT брокеру
+     * @brief Асинхронное подключение к MQTT брокеру.
+     * Не ждёт ответа брокера: результат приходит через callback
+     * состояния (CONNECTED или FAILED) из потока Paho
      * @param config Конфигурация подключения
-     * @return true если подключение успешно
+     * @return true если подключение начато
      */
     bool connect(const ConnectionConfig& config);
 
@@ -41,11 +50,19 @@ public:
     void disconnect();
 
     /**
-     * @brief Проверка состояния подключения
+     * @brief Проверка состояния подключения (только атомарное состояние,
+     * клиент не трогается)
      * @return true если подключен
      */
     bool isConnected() const;
 
+    /**
+     * @brief Брокер сохранил сессию с прошлого подключения
+     * (подписки и неподтверждённые QoS1 сообщения живы)
+     * @return true если сессия восстановлена
+     */
+    bool isSessionPresent() const;
+
     /**
      * @brief Получение текущего состояния подключения
      * @return Состояние подключения
@@ -65,15 +82,33 @@ public:
     void setErrorCallback(ErrorCallback callback);
 
     /**
-     * @brief Получение клиента MQTT (внутреннее)
-     * @return Указатель на MQTT клиент
+     * @brief Асинхронная публикация текущим клиентом. Клиент берётся под
+     * client_mutex_ и не может быть удалён или заменён посреди вызова;
+     * подтверждение придёт в listener из потока Paho
+     * @param context user context токена
+     * @return false если клиента нет; ошибки Paho - исключением
+     */
+    bool publish(const std::shared_ptr<mqtt::message>& message, void* context,
+                 mqtt::iaction_listener& listener);
+
+    /**
+     * @brief Подписка текущим клиентом под client_mutex_, без ожидания
+     * @return false если клиента нет; ошибки Paho - исключением
      */
-    mqtt::async_client* getClient();
+    bool subscribe(const std::string& topic, int qos);
 
     /**
-     * @brief Включение/отключение автоматического переподключения
+     * @brief Отписка текущим клиентом под client_mutex_, без ожидания
+     * @return false если клиента нет; ошибки Paho - исключением
+     */
+    bool unsubscribe(const std::string& topic);
+
+    /**
+     * @brief Включение/отключение автоматического переподключения.
+     * Попытки идут по событию потери связи с экспоненциально растущей
+     * задержкой со случайным разбросом
      * @param enable true для включения автоматического переподключения
-     * @param retry_interval Интервал между попытками в секундах
+     * @param retry_interval Предел задержки между попытками в секундах
      */
     void setAutoReconnect(bool enable, int retry_interval = 5);
 
@@ -95,30 +130,102 @@ public:
      */
     void handleError(const std::string& error);
 
+    /**
+     * @brief Реакция на потерю связи (поток Paho): планирует переподключение
+     */
+    void onConnectionLost();
+
     void setMqttClient(mqtt_connector::MqttClient* mgr) { mgr_ = mgr; } // HardCode
 
+    /**
+     * @brief Номер шарда приёма, в очередь которого идут сообщения
+     */
+    void setShard(std::size_t shard) { shard_ = shard; }
+    std::size_t shard() const { return shard_; }
+
 private:
+    static constexpr int kDisconnectTimeoutMs = 1000;
+
     std::unique_ptr<mqtt::async_client> client_;
     std::unique_ptr<mqtt::callback> callback_;
+    std::unique_ptr<mqtt::iaction_listener> connect_listener_;
+    std::unique_ptr<mqtt::connect_options> conn_opts_;
+    // защищает client_ и его пересоздание: вызовы клиента - только под ним
+    std::mutex client_mutex_;
     
     ConnectionConfig config_;
     std::atomic<ConnectionState> connection_state_;
+    std::atomic<bool> session_present_;
     ConnectionCallback connection_callback_;
     ErrorCallback error_callback_;
     
     std::atomic<bool> auto_reconnect_;
-    int retry_interval_;
     std::thread reconnect_thread_;
     std::atomic<bool> should_stop_;
+
+    // планировщик переподключения, все поля под reconnect_mutex_
+    std::mutex reconnect_mutex_;
+    std::condition_variable reconnect_cv_;
+    bool reconnect_pending_ = false;
+    std::chrono::steady_clock::time_point reconnect_at_;
+    int reconnect_attempts_ = 0;
+    std::chrono::milliseconds min_retry_interval_;
+    std::chrono::milliseconds max_retry_interval_;
+    std::mt19937 rng_;
     
     mutable std::mutex state_mutex_;
     std::string last_error_;
 
-    mqtt::callback* cb_; // HardCode
     mqtt_connector::MqttClient* mgr_; // HardCode
+    std::size_t shard_ = 0;
+
+    /**
+     * @brief Клиент, снятый с client_. Поля в порядке удаления наоборот:
+     * клиент удаляется раньше своего callback
+     */
+    struct DetachedClient {
+        std::unique_ptr<mqtt::callback> callback;
+        std::unique_ptr<mqtt::connect_options> options;
+        std::unique_ptr<mqtt::async_client> client;
+    };
+
+    /**
+     * @brief Снимает текущий клиент, вызывается под client_mutex_
+     */
+    DetachedClient detachLocked();
+
+    /**
+     * @brief Токен выдан текущим клиентом, а не уже снятым
+     */
+    bool isCurrent(const mqtt::token& tok);
+
+    /**
+     * @brief Отключает и удаляет снятый клиент, вызывается без client_mutex_:
+     * поток Paho этого клиента может ждать мьютекс в subscribe() из
+     * connect_listener_, и удерживая его, мы бы удалили клиент из-под
+     * собственного callback
+     */
+    void closeDetached(DetachedClient old);
+
+    /**
+     * @brief Планирует попытку переподключения. Задержка растёт
+     * экспоненциально и выбирается случайно в [min, предел] (full jitter),
+     * чтобы клиенты не ломились к перезапущенному брокеру одновременно
+     */
+    void scheduleReconnect();
+
+    /**
+     * @brief Отмена запланированной попытки и сброс счётчика
+     */
+    void cancelReconnect();
+
+    /**
+     * @brief Повторное подключение тем же клиентом и с той же сессией
+     */
+    void attemptReconnect();
 
     /**
-     * @brief Поток автоматического переподключения
+     * @brief Поток-планировщик: спит до назначенной попытки
      */
     void reconnectLoop();
 };
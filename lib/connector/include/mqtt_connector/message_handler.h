@@ -1,15 +1,26 @@
 #pragma once
 
-#include <unordered_map>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "types.h"
 
 namespace mqtt_connector {
 
 /**
- * @brief Класс для обработки входящих MQTT сообщений
+ * @brief Класс для обработки входящих MQTT сообщений.
+ *
+ * Обработчики регистрируются по фильтру топика с wildcards MQTT
+ * (+ - один уровень, # - остаток топика, $share/<группа>/ отбрасывается)
+ * и хранятся в префиксном дереве по уровням топика. Дерево неизменяемо:
+ * запись строит новое и подменяет указатель, поэтому чтение в потоках
+ * Paho идёт без блокировок, а обработчики вызываются вне мьютексов.
  */
 class MessageHandler {
 public:
@@ -17,20 +28,21 @@ public:
     ~MessageHandler();
 
     /**
-     * @brief Регистрация обработчика для конкретного топика
-     * @param topic Топик для подписки
+     * @brief Регистрация обработчика для фильтра топика
+     * @param topic Фильтр топика (поддерживает wildcards: +, #)
      * @param callback Функция обработки сообщений
      */
     void registerHandler(const std::string& topic, MessageCallback callback);
 
     /**
-     * @brief Удаление обработчика для топика
-     * @param topic Топик для удаления
+     * @brief Удаление обработчика для фильтра топика
+     * @param topic Фильтр, под которым обработчик был зарегистрирован
      */
     void unregisterHandler(const std::string& topic);
 
     /**
-     * @brief Обработка входящего сообщения
+     * @brief Обработка входящего сообщения: вызывает все обработчики,
+     * чьи фильтры подходят к топику, иначе обработчик по умолчанию
      * @param message Полученное сообщение
      */
     void handleMessage(const Message& message);
@@ -52,10 +64,52 @@ public:
      */
     void clearHandlers();
 
+    /**
+     * @brief Подходит ли топик под фильтр по правилам MQTT
+     * @param filter Фильтр подписки
+     * @param topic Топик сообщения
+     */
+    static bool topicMatches(std::string_view filter, std::string_view topic);
+
 private:
-    std::unordered_map<std::string, MessageCallback> handlers_;
-    MessageCallback default_handler_;
+    /**
+     * @brief Узел дерева: один уровень фильтра
+     */
+    struct LevelHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view level) const {
+            return std::hash<std::string_view>{}(level);
+        }
+    };
+
+    struct Node {
+        // прозрачный поиск по string_view: без аллокаций на каждый уровень
+        std::unordered_map<std::string, std::unique_ptr<Node>, LevelHash,
+                           std::equal_to<>>
+            children;
+        std::vector<const MessageCallback*> handlers;
+    };
+
+    /**
+     * @brief Неизменяемый снимок таблицы обработчиков
+     */
+    struct Table {
+        std::map<std::string, MessageCallback> filters;  ///< исходные фильтры
+        MessageCallback default_handler;
+        Node root;  ///< ссылается на колбэки из filters
+    };
+
+    // запись (редкая) под мьютексом, чтение - атомарной загрузкой снимка
+    std::atomic<std::shared_ptr<const Table>> table_;
     mutable std::mutex handlers_mutex_;
+
+    /**
+     * @brief Строит дерево по фильтрам и публикует новый снимок
+     */
+    void publish(std::shared_ptr<Table> table);
+
+    static void collect(const Node& node, const std::vector<std::string_view>& levels,
+                        std::size_t level, std::vector<const MessageCallback*>& out);
 };
 
 } // namespace mqtt_connector
@@ -4,14 +4,24 @@
 #include "message_handler.h"
 #include "message_objects/BLE.h"
 #include "connection_manager.h"
+#include "publisher.h"
+#include "position_publisher.h"
 #include "navigator/navigator.h"
+#include "recorder/recorder.h"
+#include "metrics/metrics.h"
+#include "metrics/exporter.h"
+#include "advert_dedup.h"
+#include "zones/zones.h"
 
 #include <mqtt/callback.h>
+#include <map>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 
 #include <QObject>
@@ -32,9 +42,10 @@ public:
     ~MqttClient();
 
     /**
-     * @brief Инициализация и подключение к MQTT брокеру
+     * @brief Инициализация и асинхронное подключение к MQTT брокеру.
+     * Возвращается сразу, ход подключения сообщает setConnectStatus
      * @param config Конфигурация подключения
-     * @return true если подключение успешно
+     * @return true если подключение начато
      */
     bool initialize(const ConnectionConfig& config);
 
@@ -43,12 +54,42 @@ public:
      */
     void shutdown();
 
+    /**
+     * @brief Режим воспроизведения: без брокера и без потока обработки.
+     * Сообщения подаются в onMessageReceived (или сразу в addBLEBeaconState),
+     * такты - вызовом processTick
+     * @param shards Число очередей приёма (по одной на поток-источник)
+     */
+    void initializeReplay(std::size_t shards = 1);
+
+    /**
+     * @brief Один такт обработки: забирает накопленные измерения
+     * и считает позиции всех меток
+     * @param now_ms Время такта, мс с эпохи (в воспроизведении - время записи)
+     * @return Число вычисленных позиций
+     */
+    std::size_t processTick(std::int64_t now_ms);
+
+    /**
+     * @brief Настройки навигатора; навигаторы меток создаются заново
+     * @param config Коэффициенты сглаживания и пороги
+     */
+    void setNavigatorConfig(const navigator::NavigatorConfig& config);
+
+    /**
+     * @brief Текущая частота тактов обработки, Гц
+     */
+    float frequency() const {
+        std::lock_guard<std::mutex> lock(m_freq_mutex_);
+        return m_freq;
+    }
+
     /**
      * @brief Подписка на топик
      * @param topic Топик для подписки (поддерживает wildcards: +, #)
      * @param qos Quality of Service уровень (0, 1, 2)
      * @param callback Функция обработки сообщений для этого топика
-     * @return true если подписка успешна
+     * @return true если подписка запомнена (оформится без ожидания брокера)
      */
     bool subscribe(const std::string& topic, int qos = 0, MessageCallback callback = nullptr);
 
@@ -60,11 +101,12 @@ public:
     bool unsubscribe(const std::string& topic);
 
     /**
-     * @brief Публикация сообщения
+     * @brief Публикация сообщения без ожидания брокера
      * @param message Сообщение для публикации
-     * @return true если публикация успешна
+     * @param callback Результат доставки (вызывается из потока Paho)
+     * @return true если сообщение принято в очередь, false при backpressure
      */
-    bool publish(const Message& message);
+    bool publish(const Message& message, PublishCallback callback = nullptr);
 
     /**
      * @brief Публикация сообщения (расширенное)
@@ -72,10 +114,25 @@ public:
      * @param payload Содержимое сообщения
      * @param qos Quality of Service уровень
      * @param retained Флаг retained
-     * @return true если публикация успешна
+     * @return true если сообщение принято в очередь
      */
     bool publish(const std::string& topic, const std::string& payload, int qos = 0, bool retained = false);
 
+    /**
+     * @brief Публикация с future результата доставки
+     * @param message Сообщение для публикации
+     * @return future: true - брокер подтвердил, false - отказ или ошибка
+     */
+    std::future<bool> publishAsync(const Message& message);
+
+    /**
+     * @brief Публикация пачки сообщений одной постановкой в очередь
+     * @param messages Сообщения
+     * @param callback Результат доставки каждого сообщения
+     * @return true если пачка принята целиком
+     */
+    bool publishBatch(std::vector<Message> messages, PublishCallback callback = nullptr);
+
     /**
      * @brief Проверка состояния подключения
      * @return true если подключен к брокеру
@@ -119,62 +176,275 @@ public:
      */
     void setAutoReconnect(bool enable, int retry_interval = 5);
 
+    /**
+     * @brief Настройка выдачи вычисленных позиций в MQTT
+     * @param options Топик, кодирование, ограничение частоты и сдвига
+     */
+    void setPositionStream(const PositionStreamOptions& options);
+
+    /**
+     * @brief Зоны, по которым каждая позиция даёт события zoneEvent;
+     * состояние меток в зонах сбрасывается
+     * @param zones Многоугольники, пустой список - без зон
+     * @param options Гистерезис, подтверждение, шаг сетки
+     */
+    void setZones(std::vector<zones::Zone> zones, const zones::ZoneOptions& options = {});
+
+    /**
+     * @brief Настройка выдачи событий зон в MQTT
+     */
+    void setZoneStream(const ZoneStreamOptions& options);
+
+    /**
+     * @brief Запись всех принятых объявлений в журнал (до фильтра маяков)
+     * @param options Каталог, ротация, размер чанка
+     */
+    void startRecording(const recorder::RecorderOptions& options);
+
+    /**
+     * @brief Остановка записи, накопленное дописывается в файл
+     */
+    void stopRecording();
+
     /**
      * @brief Получение статистики клиента
-     * @return Строка с информацией о состоянии
+     * @return Строка с информацией о состоянии и метриками
      */
     std::string getStatus() const;
 
+    /**
+     * @brief Измерений в очередях приёма до следующего такта
+     * (то же, что bacon_ingest_queue_depth)
+     */
+    std::size_t queuedSamples() const;
+
+    /**
+     * @brief Метрики конвейера: приём, очередь, расчёт, задержки.
+     * Читаются без остановки обработки; сюда же можно регистрировать свои
+     */
+    metrics::Registry& metrics() { return metrics_; }
+    const metrics::Registry& metrics() const { return metrics_; }
+
+    /**
+     * @brief HTTP-эндпоинт метрик в формате Prometheus (GET /metrics)
+     * в собственном потоке; повторный вызов перезапускает с новыми настройками
+     * @param options Адрес и порт
+     * @return false если порт не удалось открыть
+     */
+    bool startMetricsExporter(const metrics::ExporterOptions& options);
+
+    void stopMetricsExporter();
+
     void setBLEBeaconState(const std::string& key, const std::vector<message_objects::BLEBeaconState>& states);
     void addBLEBeaconState(const std::string& key, const message_objects::BLEBeaconState& state);
-    
-    void clearBLEBeaconStates() {
-        std::lock_guard<std::mutex> lock(m_data_mutex_);
-        m_data.clear();
-    }
 
-    bool BLEBeaconContains(const std::string& name);
+    /**
+     * @brief Добавление измерения в очередь шарда приёма
+     * @param shard Номер шарда (подключения), из которого пришло сообщение
+     * @param key Имя маяка
+     * @param state Измерение
+     * @param capture_ms Время записи при воспроизведении, 0 - живое:
+     * окно отсева копий считается по нему
+     */
+    void addBLEBeaconState(std::size_t shard, const std::string& key,
+                           const message_objects::BLEBeaconState& state,
+                           std::int64_t capture_ms = 0);
+
+    void clearBLEBeaconStates();
+
+    /**
+     * @brief Известен ли маяк. Без блокировок: читает снимок имён
+     */
+    bool BLEBeaconContains(const std::string& name) const;
+
+    /**
+     * @brief Входящее сообщение (поток Paho): передаётся обработчикам,
+     * подписанным на подходящий фильтр топика
+     * @param message Полученное сообщение
+     */
+    void onMessageReceived(const Message& message);
 
     Q_SIGNALS:
-    void addPathPoint(const QPointF &pos);
+    /**
+     * @brief Новая позиция отслеживаемого устройства
+     * @param tag Метка устройства (kDefaultTag, если в сообщениях её нет)
+     * @param pos Координаты в метрах
+     */
+    void addPathPoint(const QString &tag, const QPointF &pos);
     void setConnectStatus(const QString &status);
 
+    /**
+     * @brief Очередь публикации заполнена (true) или разгружена (false)
+     */
+    void publishBackpressure(bool engaged);
+
+    /**
+     * @brief Метка вошла в зону, вышла из неё или пробыла в ней dwell_s
+     * @param event "enter", "exit" или "dwell"
+     * @param pos Позиция, вызвавшая событие, м
+     */
+    void zoneEvent(const QString &tag, const QString &zone, const QString &event,
+                   const QPointF &pos);
+
 public slots:
     void initOnChange(const QString &url);
     void setFreqOnChange(float freq);
     void setBeacons(const QList<QPair<QString, QPointF>> &newBeacons);
 
 private:
+    /**
+     * @brief Метрики горячего пути: ссылки на элементы metrics_,
+     * регистрируются один раз в конструкторе
+     */
+    struct PipelineMetrics {
+        explicit PipelineMetrics(metrics::Registry& registry);
+
+        metrics::Counter& messages_received;
+        metrics::Counter& adverts_parsed;
+        metrics::Counter& adverts_malformed;
+        metrics::Counter& adverts_dropped;
+        metrics::Counter& adverts_duplicate;
+        metrics::Counter& samples_fused;
+        metrics::Counter& samples_enqueued;
+        metrics::Counter& samples_dequeued;
+        metrics::Counter& positions;
+        metrics::Counter& solve_failures;
+        metrics::Histogram& samples_per_solve;
+        metrics::Histogram& solve_ns;
+        metrics::Histogram& iterations;
+        metrics::Histogram& advert_to_position_ns;
+        metrics::Counter& zone_events;
+        metrics::Histogram& zone_checks;
+    };
+
+    // раньше остальных полей: на метрики ссылаются потоки всех компонентов
+    metrics::Registry metrics_;
+    PipelineMetrics pipeline_metrics_;
+    // останавливается в деструкторе первым: вычисляемые метрики
+    // читают publisher_ и connection_manager_
+    std::unique_ptr<metrics::Exporter> metrics_exporter_;
+
+    // подключение шарда 0: подписки пользователя, публикация, статус
     std::unique_ptr<ConnectionManager> connection_manager_;
+    // подключения шардов 1..N-1, только приём объявлений маяков
+    std::vector<std::unique_ptr<ConnectionManager>> shard_connections_;
     std::unique_ptr<MessageHandler> message_handler_;
+    // после connection_manager_: удаляется раньше подключения
+    std::unique_ptr<Publisher> publisher_;
+    std::unique_ptr<PositionPublisher> position_publisher_;
+
+    // события зон: движок и буфер событий - только в такте обработки
+    zones::ZoneEngine zone_engine_;
+    std::vector<zones::ZoneEvent> zone_events_;
+    ZoneStreamOptions zone_stream_;
+    mutable std::mutex zone_stream_mutex_;
     
-    std::vector<std::string> subscriptions_;
+    // Hardcode: топик, в который шлют данные esp
+    static constexpr char kAdvertTopic[] = "hakaton/board";
+    static constexpr int kAdvertQos = 1;
+
+    std::vector<Subscription> subscriptions_;
     mutable std::mutex subscriptions_mutex_;
     
     ConnectionConfig current_config_;
     bool initialized_;
 
     /**
-     * @brief Внутренний обработчик входящих сообщений
-     * @param message Полученное сообщение
+     * @brief Разбор объявления маяка (JSON) в очередь шарда
+     * @param message Сообщение из топика объявлений
      */
-    void onMessageReceived(const Message& message);
+    void decodeAdvert(const Message& message);
+
+    /**
+     * @brief Сигналы и публикация накопленных zone_events_ (поток такта)
+     */
+    void publishZoneEvents();
 
     /**
      * @brief Восстановление подписок после переподключения
      */
     void restoreSubscriptions();
 
+    /**
+     * @brief Реакция на смену состояния подключения (поток Paho)
+     * @param state Новое состояние
+     */
+    void onConnectionStateChanged(ConnectionState state);
+
+    /**
+     * @brief Смена состояния подключения шарда 1..N-1 (поток Paho)
+     * @param shard Подключение шарда
+     * @param state Новое состояние
+     */
+    void onShardStateChanged(ConnectionManager* shard, ConnectionState state);
+
+    /**
+     * @brief Топик объявлений: при нескольких шардах - shared subscription,
+     * брокер раздаёт сообщения между подключениями группы
+     */
+    std::string advertTopic() const;
+
     float m_freq = 1.0f;
     mutable std::mutex m_freq_mutex_;
 
-    std::map<std::string, std::vector<message_objects::BLEBeaconState>> m_data;
-    mutable std::mutex m_data_mutex_;
+    using BeaconSamples =
+        std::map<std::string, std::vector<message_objects::BLEBeaconState>>;
+
+    /**
+     * @brief Измерения одной метки за тик и время прихода первого из них
+     * (для задержки объявление -> позиция)
+     */
+    struct TagSamples {
+        BeaconSamples beacons;
+        std::chrono::steady_clock::time_point first_arrival;
+    };
+
+    /**
+     * @brief Очередь приёма одного подключения: свой мьютекс,
+     * поэтому потоки Paho разных шардов не мешают друг другу
+     */
+    struct IngestShard {
+        std::mutex mutex;
+        // метка устройства -> маяк -> измерения за текущий тик
+        std::map<std::string, TagSamples> data;
+    };
+
+    std::vector<std::unique_ptr<IngestShard>> ingest_shards_;
+
+    // отсев копий от нескольких шлюзов, nullptr - выключен;
+    // пересоздаётся вместе с очередями, пока потоки Paho не запущены
+    std::unique_ptr<AdvertDeduplicator> dedup_;
+    // номер такта: копия объявления, ушедшего в прошлый такт, опоздала
+    std::atomic<std::uint32_t> tick_generation_{0};
 
     std::vector<message_objects::BLEBeacon> m_beacons;
     mutable std::mutex m_beacons_mutex_;
 
-    std::unique_ptr<navigator::Navigator> navigator_;
+    // журнал объявлений, читается в потоках Paho без блокировок
+    std::atomic<std::shared_ptr<recorder::Recorder>> recorder_;
+
+    // снимок имён маяков для фильтра в потоках Paho, заменяется целиком
+    std::atomic<std::shared_ptr<const std::unordered_set<std::string>>>
+        beacon_names_;
+
+    // У каждого устройства своё сглаживание, поэтому и свой навигатор.
+    // Навигатор считает только поток такта, уже без navigators_mutex_:
+    // shared_ptr держит его, даже если запись тем временем удалили
+    struct TagNavigator {
+        std::shared_ptr<navigator::Navigator> navigator;
+        std::uint64_t beacons_version = 0;  // с какими маяками навигатор
+        std::int64_t seen_ms = 0;           // такт последних измерений
+    };
+    std::map<std::string, TagNavigator> navigators_;
+    navigator::NavigatorConfig navigator_config_;  // под navigators_mutex_
+    std::uint64_t beacons_version_ = 0;            // под navigators_mutex_
+    std::mutex navigators_mutex_;
+
+    // метка без измерений дольше этого забывается навигатором, зонами
+    // и выдачей позиций
+    static constexpr std::int64_t kTagIdleMs = 10 * 60 * 1000;
+    static constexpr std::int64_t kIdleSweepMs = 10 * 1000;
+    std::int64_t idle_swept_ms_ = 0;  // только в такте обработки
 
     std::thread processing_thread_;
     std::atomic<bool> should_stop_processing_{false};
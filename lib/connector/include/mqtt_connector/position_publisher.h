@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "types.h"
+
+namespace mqtt_connector {
+
+class Publisher;
+
+/**
+ * @brief Выдача вычисленных позиций в MQTT.
+ *
+ * Позиция каждой метки публикуется в <topic_prefix>/<tag> не чаще
+ * max_rate_hz и только если метка сдвинулась хотя бы на min_delta
+ * с последней опубликованной позиции. Отправка идёт через Publisher
+ * и не блокирует поток навигации: при переполнении очереди позиция
+ * отбрасывается, следующая всё равно будет свежее.
+ *
+ * Метка приходит из объявления как есть, поэтому метка, которая не может
+ * быть уровнем топика (пустая, с '/', '+', '#'), не публикуется.
+ */
+class PositionPublisher {
+public:
+    explicit PositionPublisher(Publisher* publisher);
+
+    void setOptions(const PositionStreamOptions& options);
+
+    PositionStreamOptions options() const;
+
+    /**
+     * @brief Новая позиция метки
+     * @param tag Метка устройства
+     * @param x Координата, м
+     * @param y Координата, м
+     * @param timestamp_ms Время вычисления, мс с эпохи
+     * @return true если позиция ушла в очередь публикации
+     */
+    bool offer(const std::string& tag, double x, double y,
+               std::int64_t timestamp_ms);
+
+    /**
+     * @brief Забыть последние позиции (например, после переподключения)
+     */
+    void reset();
+
+    /**
+     * @brief Забыть метки, не публиковавшиеся дольше idle_ms; следующая
+     * позиция такой метки уйдёт без проверки частоты и сдвига
+     * @return Число забытых меток
+     */
+    std::size_t evictIdle(std::int64_t now_ms, std::int64_t idle_ms);
+
+    std::uint64_t published() const;
+
+    std::uint64_t suppressed() const;
+
+    /**
+     * @brief Позиции меток, непригодных для топика
+     */
+    std::uint64_t rejected() const;
+
+    /**
+     * @brief Метка годится в уровень топика MQTT: не пустая, без
+     * разделителя '/', шаблонов '+' и '#' и нулевого символа
+     */
+    static bool isValidTopicLevel(const std::string& tag);
+
+    static std::string encodeJson(const std::string& tag, double x, double y,
+                                  std::int64_t timestamp_ms);
+
+    /**
+     * @brief Двоичная запись, little-endian:
+     * "BP" | u8 версия (1) | u8 длина метки | метка | i64 ts, мс |
+     * f32 x | f32 y
+     */
+    static std::string encodeBinary(const std::string& tag, double x, double y,
+                                    std::int64_t timestamp_ms);
+
+private:
+    struct LastSent {
+        double x = 0;
+        double y = 0;
+        std::int64_t timestamp_ms = 0;
+    };
+
+    Publisher* publisher_;
+
+    mutable std::mutex mutex_;
+    PositionStreamOptions options_;
+    std::unordered_map<std::string, LastSent> last_sent_;
+    std::uint64_t published_ = 0;
+    std::uint64_t suppressed_ = 0;
+    std::uint64_t rejected_ = 0;
+};
+
+} // namespace mqtt_connector
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+// Forward declarations Paho MQTT
+namespace mqtt {
+    class iaction_listener;
+}
+
+namespace mqtt_connector {
+
+class ConnectionManager;
+
+/**
+ * @brief Конвейер асинхронной публикации.
+ *
+ * publish() только ставит сообщение в очередь и сразу возвращается.
+ * Поток отправки забирает сообщения пачками и отдаёт их Paho, не дожидаясь
+ * подтверждений, пока число неподтверждённых не достигнет окна
+ * max_in_flight. Каждое сообщение остаётся отдельной публикацией. Результат доставки приходит в колбэк или future.
+ * При заполнении очереди до max_queued новые сообщения отклоняются и
+ * включается backpressure; снимается он при падении до low_watermark.
+ */
+class Publisher {
+public:
+    explicit Publisher(ConnectionManager* connection,
+                       PublisherOptions options = PublisherOptions());
+    ~Publisher();
+
+    Publisher(const Publisher&) = delete;
+    Publisher& operator=(const Publisher&) = delete;
+
+    /**
+     * @brief Постановка сообщения в очередь
+     * @param message Сообщение
+     * @param callback Результат доставки (поток Paho или поток отправки)
+     * @return false если очередь заполнена (backpressure)
+     */
+    bool publish(Message message, PublishCallback callback = nullptr);
+
+    /**
+     * @brief Постановка сообщения в очередь с future результата
+     * @return future, false в котором означает отказ или ошибку доставки
+     */
+    std::future<bool> publishAsync(Message message);
+
+    /**
+     * @brief Постановка пачки сообщений одной блокировкой: либо вся пачка,
+     * либо ничего
+     * @return false если пачка не помещается в очередь
+     */
+    bool publishBatch(std::vector<Message> messages,
+                      PublishCallback callback = nullptr);
+
+    /**
+     * @brief Колбэк включения/снятия backpressure
+     */
+    void setBackpressureCallback(BackpressureCallback callback);
+
+    bool isBackpressured() const { return backpressured_; }
+
+    std::size_t queued() const;
+
+    std::size_t inFlight() const;
+
+    /**
+     * @brief Подключение изменилось: будит поток отправки, а при новом
+     * клиенте (CONNECTING) отменяет публикации старого
+     */
+    void onConnectionStateChanged(ConnectionState state);
+
+    /**
+     * @brief Отклоняет всё в очереди и в полёте
+     */
+    void clear();
+
+private:
+    struct Pending {
+        Message message;
+        PublishCallback callback;
+    };
+
+    using PendingId = std::uintptr_t;
+
+    class DeliveryListener;
+
+    ConnectionManager* connection_;
+    PublisherOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> queue_;
+    // отданные Paho сообщения по id; id - user context токена,
+    // поэтому поздний ответ на отменённое сообщение просто не найдётся
+    std::unordered_map<PendingId, Pending> in_flight_;
+    PendingId next_id_ = 1;
+    std::atomic<bool> backpressured_{false};
+    BackpressureCallback backpressure_callback_;
+
+    std::unique_ptr<mqtt::iaction_listener> listener_;
+    std::thread sender_thread_;
+    bool should_stop_ = false;
+    bool connected_;  ///< Под mutex_, из onConnectionStateChanged
+
+    void senderLoop();
+
+    void complete(PendingId id, bool delivered);
+
+    /**
+     * @brief Пересчёт backpressure, вызывается под mutex_
+     * @return новое состояние, если оно изменилось
+     */
+    std::optional<bool> updateBackpressureLocked();
+
+    void notifyBackpressure(std::optional<bool> changed);
+};
+
+} // namespace mqtt_connector
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <memory>
@@ -18,6 +19,12 @@ struct ConnectionConfig {
     bool clean_session = true;              ///< Флаг очистки сессии
     int connection_timeout = 30;            ///< Таймаут подключения в секундах
     bool use_ssl = false;                   ///< Использовать SSL/TLS
+    bool auto_reconnect = true;             ///< Переподключаться при потере связи
+    int min_retry_interval_ms = 500;        ///< Начальная задержка переподключения
+    int max_retry_interval_ms = 30000;      ///< Предел задержки переподключения
+    int ingest_shards = 1;                  ///< Число параллельных подключений приёма
+    std::string shared_group = "bacon";     ///< Группа shared subscription ($share/...)
+    int dedup_window_ms = 500;              ///< Окно отсева копий объявления от разных шлюзов, 0 - выключить
 };
 
 /**
@@ -28,12 +35,60 @@ struct Message {
     std::string payload;                    ///< Содержимое сообщения
     int qos = 0;                           ///< Quality of Service (0, 1, 2)
     bool retained = false;                  ///< Флаг сохранения сообщения
+    std::size_t shard = 0;                  ///< Шард приёма, из которого пришло
+    std::int64_t timestamp_ms = 0;          ///< Время записи при воспроизведении, 0 - живое
     
     Message() = default;
     Message(const std::string& topic, const std::string& payload, int qos = 0, bool retained = false)
         : topic(topic), payload(payload), qos(qos), retained(retained) {}
 };
 
+/**
+ * @brief Настройки конвейера публикации
+ */
+struct PublisherOptions {
+    std::size_t max_in_flight = 64;         ///< Неподтверждённых публикаций одновременно
+    std::size_t max_queued = 4096;          ///< Предел очереди, дальше - отказ
+    std::size_t low_watermark = 1024;       ///< Уровень снятия backpressure
+};
+
+/**
+ * @brief Кодирование вычисленных позиций
+ */
+enum class PositionEncoding {
+    JSON,           ///< {"tag":..,"x":..,"y":..,"ts":..}
+    BINARY          ///< Компактная запись, см. PositionPublisher::encodeBinary
+};
+
+/**
+ * @brief Настройки выдачи позиций в MQTT
+ */
+struct PositionStreamOptions {
+    bool enabled = false;                   ///< Публиковать позиции
+    std::string topic_prefix = "bacon/positions"; ///< Топик: <prefix>/<tag>
+    PositionEncoding encoding = PositionEncoding::JSON;
+    int qos = 0;                            ///< Quality of Service (0, 1, 2)
+    double max_rate_hz = 10.0;              ///< Не чаще, на каждую метку; 0 - без ограничения
+    double min_delta = 0.05;                ///< Сдвиг меньше этого (м) не публикуется
+};
+
+/**
+ * @brief Настройки выдачи событий зон в MQTT
+ */
+struct ZoneStreamOptions {
+    bool enabled = false;                   ///< Публиковать события
+    std::string topic_prefix = "bacon/zones"; ///< Топик: <prefix>/<зона>
+    int qos = 1;                            ///< Событие не должно теряться, в отличие от позиции
+};
+
+/**
+ * @brief Подписка на топик
+ */
+struct Subscription {
+    std::string topic;                      ///< Фильтр топика
+    int qos = 0;                            ///< Quality of Service (0, 1, 2)
+};
+
 /**
  * @brief Перечисление состояний подключения
  */
@@ -48,5 +103,7 @@ enum class ConnectionState {
 using MessageCallback = std::function<void(const Message& message)>;
 using ConnectionCallback = std::function<void(ConnectionState state)>;
 using ErrorCallback = std::function<void(const std::string& error)>;
+using PublishCallback = std::function<void(bool delivered)>;
+using BackpressureCallback = std::function<void(bool engaged)>;
 
 } // namespace mqtt_connector
@@ -1,5 +1,7 @@
 #pragma once
 #include "message_objects/BLE.h"
+#include "navigator/solver.h"
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -7,11 +9,34 @@
 
 namespace navigator {
 
+// Настройки навигатора; значения по умолчанию - те, что были зашиты в код
+struct NavigatorConfig {
+    double alpha = 0.2;             // EMA расстояний
+    double position_alpha = 0.65;   // EMA координат (вес нового измерения)
+    double max_jump = 0.0;          // предел сдвига сглаженного расстояния за такт, м; 0 - нет
+    double max_distance = 30.0;     // дальше - шум, отбрасывается
+    double path_loss_exponent = 3.0;
+    double min_distance = 0.5;
+    double iqr_k = 1.5;             // отсечение выбросов медианы
+    TrilaterationParams trilateration;
+};
+
+// Что ушло в последний расчёт позиции (для метрик)
+struct SolveStats {
+    std::size_t samples = 0;    // измерений RSSI
+    std::size_t beacons = 0;    // маяков в триангуляции
+    int iterations = 0;         // шагов градиентного спуска
+};
+
 class Navigator {
    public:
-    // Конструктор принимает список известных маяков и коэффициент сглаживания для расстояний
-    Navigator(const std::vector<message_objects::BLEBeacon>& knownBeacons,
-              double alpha = 0.2, double positionAlpha = 0.3);
+    // Конструктор принимает список известных маяков и настройки сглаживания
+    explicit Navigator(const std::vector<message_objects::BLEBeacon>& knownBeacons,
+                       NavigatorConfig config = NavigatorConfig());
+
+    const NavigatorConfig& config() const { return config_; }
+
+    const SolveStats& lastSolve() const { return lastSolve_; }
 
     void setKnownBeacons(std::vector<message_objects::BLEBeacon> newBeacons);
 
@@ -25,11 +50,9 @@ class Navigator {
     // Список известных маяков
     std::vector<message_objects::BLEBeacon> knownBeacons_;
 
-    // Коэффициент EMA для расстояний
-    double alpha_;
+    NavigatorConfig config_;
 
-    // Коэффициент EMA для координат
-    double positionAlpha_;
+    SolveStats lastSolve_;
 
     // Карта "имя маяка → сглаженное значение расстояния"
     mutable std::unordered_map<std::string, double> emaMap_;
@@ -38,23 +61,12 @@ class Navigator {
     mutable std::pair<double, double> lastPosition_;
     mutable bool lastPositionInitialized_ = false;
 
-    // Преобразование RSSI → расстояние
-    double rssiToDistance(int rssi, int txPower) const;
-
-    // Фильтрация и медиана с IQR
-    double calculateMedian(std::vector<double>& values) const;
-
     // Адаптивный EMA для расстояний
     double updateMovingAverage(const std::string& beaconName, double newValue);
 
     // EMA на координаты
     std::pair<double, double> applyPositionEMA(
         const std::pair<double, double>& newPos) const;
-
-    // Триангуляция по сглаженным расстояниям (взвешенная)
-    std::pair<double, double> trilateration(
-        std::vector<std::pair<message_objects::BLEBeacon, double>>& distances)
-        const;
 };
 
 }  // namespace navigator
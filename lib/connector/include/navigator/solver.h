@@ -0,0 +1,34 @@
+#pragma once
+#include "message_objects/BLE.h"
+#include <utility>
+#include <vector>
+
+namespace navigator {
+
+// Вычислительное ядро навигатора: чистые функции без состояния.
+// Сглаживание (EMA расстояний и координат) остаётся в Navigator.
+
+// Параметры градиентного спуска в trilaterate
+struct TrilaterationParams {
+    int max_iterations = 200;
+    double learning_rate = 0.2;
+    double tolerance = 1e-4;  // шаг меньше - остановка
+};
+
+// Преобразование RSSI → расстояние, м (log-distance);
+// n - показатель затухания, ближе min_distance не бывает
+double rssiToDistance(int rssi, int txPower, double n = 3.0,
+                      double min_distance = 0.5);
+
+// Медиана после отсечения выбросов за [q1 - k·IQR, q3 + k·IQR];
+// values сортируется на месте
+double filteredMedian(std::vector<double>& values, double iqr_k = 1.5);
+
+// Триангуляция по расстояниям до маяков (градиентный спуск, равные веса);
+// в iterations, если передан, - число сделанных шагов
+std::pair<double, double> trilaterate(
+    const std::vector<std::pair<message_objects::BLEBeacon, double>>& distances,
+    const TrilaterationParams& params = TrilaterationParams(),
+    int* iterations = nullptr);
+
+}  // namespace navigator
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message_objects/BLE.h"
+
+namespace recorder {
+
+/**
+ * Формат журнала объявлений (все числа little-endian):
+ *
+ *   файл   := "BACONLOG" | u32 версия | чанк*
+ *   чанк   := u32 размер сжатых данных | u32 число записей | qCompress(записи)
+ *   запись := u16 длина остатка | i64 время, мкс с эпохи | u8 шард |
+ *             str8 топик | str8 имя маяка | str8 метка | i16 rssi | i16 txPower |
+ *             str8 шлюз | u32 seq                          (с версии 2)
+ *   str8   := u8 длина | байты
+ *
+ * Чанк пишется целиком, поэтому оборванный хвост файла теряет только
+ * последний неполный чанк.
+ */
+inline constexpr char kLogMagic[8] = {'B', 'A', 'C', 'O', 'N', 'L', 'O', 'G'};
+inline constexpr std::uint32_t kLogVersion = 2;
+
+/**
+ * Одно принятое измерение
+ */
+struct AdvertSample {
+    std::int64_t timestamp_us = 0;
+    std::uint8_t shard = 0;
+    std::string topic;
+    message_objects::BLEBeaconState state;
+};
+
+/**
+ * Кодирование записи в конец буфера
+ */
+void encodeSample(const AdvertSample& sample, QByteArray& out);
+
+/**
+ * Разбор записи с позиции offset, offset сдвигается за запись
+ * @return false если данные кончились или запись повреждена
+ */
+bool decodeSample(const QByteArray& data, qsizetype& offset,
+                  AdvertSample& sample);
+
+struct RecorderOptions {
+    std::string directory = ".";            // каталог журналов
+    std::string prefix = "adverts";         // <prefix>-<время>.blog
+    std::size_t chunk_bytes = 256 * 1024;   // несжатый размер чанка, примерно
+    int flush_interval_ms = 500;            // чанк не ждёт дольше
+    std::uint64_t max_file_bytes = 256ull * 1024 * 1024;  // ротация по размеру
+    int max_file_seconds = 3600;            // ротация по времени, 0 - нет
+    std::size_t max_pending = 1 << 20;      // записей в памяти, дальше - отброс
+    int compression_level = 1;              // уровень zlib для qCompress
+};
+
+/**
+ * Запись сырых объявлений в журнал.
+ *
+ * record() вызывается из потоков Paho и только кладёт запись в буфер
+ * своего шарда (мьютекс шарда делится лишь с писателем на время обмена
+ * буферов). Кодирование, сжатие, запись на диск и ротация файлов -
+ * в отдельном потоке.
+ */
+class Recorder {
+   public:
+    Recorder(RecorderOptions options, std::size_t shards);
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    void record(std::size_t shard, const std::string& topic,
+                const message_objects::BLEBeaconState& state);
+
+    /**
+     * Дописывает всё накопленное и закрывает файл
+     */
+    void stop();
+
+    std::uint64_t recorded() const { return recorded_; }
+
+    std::uint64_t dropped() const { return dropped_; }
+
+    std::string currentFile() const;
+
+   private:
+    struct ShardBuffer {
+        std::mutex mutex;
+        std::vector<AdvertSample> samples;
+    };
+
+    RecorderOptions options_;
+    std::size_t chunk_records_;             // записей в чанке по оценке из chunk_bytes
+    std::vector<std::unique_ptr<ShardBuffer>> shards_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::uint64_t> recorded_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    bool should_stop_ = false;
+    std::thread writer_thread_;
+
+    // поля ниже - только поток записи (и currentFile под file_mutex_)
+    mutable std::mutex file_mutex_;
+    std::ofstream file_;
+    std::string file_path_;
+    std::uint64_t file_bytes_ = 0;
+    std::chrono::steady_clock::time_point file_opened_;
+
+    void writerLoop();
+
+    void drain(std::vector<AdvertSample>& out);
+
+    void writeChunk(std::span<const AdvertSample> samples);
+
+    void rotateIfNeeded();
+
+    void openFile();
+};
+
+}  // namespace recorder
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "recorder/recorder.h"
+
+namespace mqtt_connector {
+class MqttClient;
+}
+
+namespace recorder {
+
+/**
+ * Последовательный источник записанных измерений
+ */
+class SampleSource {
+   public:
+    virtual ~SampleSource() = default;
+
+    /**
+     * @return false когда записи кончились
+     */
+    virtual bool next(AdvertSample& sample) = 0;
+};
+
+/**
+ * Чтение журнала Recorder (формат описан в recorder.h) по чанкам
+ */
+class LogReader : public SampleSource {
+   public:
+    explicit LogReader(const std::string& path);
+
+    bool next(AdvertSample& sample) override;
+
+   private:
+    std::ifstream file_;
+    QByteArray chunk_;
+    qsizetype offset_ = 0;
+
+    bool readChunk();
+};
+
+/**
+ * Чтение CSV-выгрузки шлюза: строки "ts_ms,name,rssi,tx_power[,tag]".
+ * Заголовок и строки, которые не разбираются, пропускаются.
+ */
+class CsvReader : public SampleSource {
+   public:
+    CsvReader(const std::string& path, std::string topic);
+
+    bool next(AdvertSample& sample) override;
+
+   private:
+    std::ifstream file_;
+    std::string topic_;
+};
+
+/**
+ * Источник по файлу: журнал узнаётся по сигнатуре, остальное - CSV
+ */
+std::unique_ptr<SampleSource> openSamples(const std::string& path,
+                                          const std::string& csv_topic);
+
+struct ReplayOptions {
+    // 1 - исходный темп, N - в N раз быстрее, 0 - без пауз
+    double speed = 1.0;
+    // вызывается перед каждым тактом с его временем, мс
+    std::function<void(std::int64_t tick_ms)> on_tick;
+};
+
+struct ReplayStats {
+    std::uint64_t samples = 0;
+    std::uint64_t ticks = 0;
+    std::uint64_t positions = 0;
+    double wall_seconds = 0;       // реальное время прогона
+    double capture_seconds = 0;    // охват записи
+};
+
+/**
+ * Подаёт записанный трафик в тот же путь, что и живой MQTT
+ * (MqttClient::onMessageReceived), минуя брокер.
+ *
+ * Такты обработки идут по времени записи, а не по часам: измерение
+ * попадает в такт, в который оно попало бы при записи, поэтому
+ * результат не зависит от скорости воспроизведения и повторяем.
+ * Клиент должен быть переведён в initializeReplay().
+ */
+class Replayer {
+   public:
+    Replayer(mqtt_connector::MqttClient* client, ReplayOptions options);
+
+    /**
+     * Прогон всего источника в вызывающем потоке
+     */
+    ReplayStats run(SampleSource& source);
+
+   private:
+    mqtt_connector::MqttClient* client_;
+    ReplayOptions options_;
+
+    std::size_t tick(std::int64_t tick_ms);
+};
+
+}  // namespace recorder
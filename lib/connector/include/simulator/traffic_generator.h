@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "message_objects/BLE.h"
+
+namespace simulator {
+
+/**
+ * Модель радиоканала: log-distance path loss + медленное затенение
+ * (коррелированный гауссов шум, дБ) + многолучёвость (замирания Райса).
+ *
+ *   rssi = txPower - 10 n lg(d) + shadow + 20 lg|h|
+ */
+struct RadioModel {
+    int tx_power = -59;                 // RSSI на 1 м, дБм
+    double path_loss_exponent = 3.0;    // n, как в Navigator::rssiToDistance
+    double shadowing_sigma_db = 4.0;    // СКО затенения
+    double shadowing_correlation = 0.9; // связь затенения соседних отсчётов, 0..1
+    double rician_k = 4.0;              // K-фактор; 0 - Рэлей, большие - почти без замираний
+    int sensitivity = -100;             // слабее - объявление не слышно
+};
+
+enum class Trajectory {
+    CIRCLE,         // окружность вокруг центра маяков
+    WAYPOINTS,      // случайные точки внутри области маяков
+};
+
+struct GeneratorOptions {
+    int tags = 1;                       // число меток
+    std::string tag_prefix = "sim";     // метки sim-0, sim-1, ...
+    Trajectory trajectory = Trajectory::WAYPOINTS;
+    double speed = 1.2;                 // скорость метки, м/с
+    double advert_interval = 0.1;       // период объявлений маяка, с
+    RadioModel radio;
+    int gateways = 1;                   // приёмников на объявление: копии с общим
+                                        // затенением и своими замираниями
+    std::uint64_t seed = 1;             // одинаковый seed - одинаковый трафик
+};
+
+/**
+ * Генератор синтетического трафика объявлений.
+ *
+ * Метки движутся по траекториям в области маяков, на каждое объявление
+ * каждого маяка каждая метка получает RSSI по RadioModel. Генератор без
+ * блокировок и аллокаций на отсчёт; для нескольких потоков создаётся по
+ * генератору на поток с разными first_tag (см. forWorker).
+ */
+class TrafficGenerator {
+   public:
+    using Sink = std::function<void(const message_objects::BLEBeaconState&)>;
+
+    TrafficGenerator(std::vector<message_objects::BLEBeacon> beacons,
+                     GeneratorOptions options, int first_tag = 0);
+
+    /**
+     * Генератор для потока worker из workers: свои метки и свой seed
+     */
+    static TrafficGenerator forWorker(
+        const std::vector<message_objects::BLEBeacon>& beacons,
+        GeneratorOptions options, int worker, int workers);
+
+    /**
+     * Один период объявлений: сдвигает метки и выдаёт по измерению
+     * на каждую пару метка-маяк, которую слышно
+     * @return число выданных измерений
+     */
+    std::size_t step(const Sink& sink);
+
+    /**
+     * Истинное положение метки (для оценки точности)
+     */
+    std::pair<double, double> position(int tag) const;
+
+    double time() const { return time_; }
+
+    int tagCount() const { return static_cast<int>(tags_.size()); }
+
+    /**
+     * RSSI на расстоянии distance по модели канала
+     */
+    int rssi(double distance, double& shadow);
+
+    /**
+     * Затухание и затенение без замираний, дБм; сдвигает затенение
+     */
+    double meanRssi(double distance, double& shadow);
+
+    /**
+     * Замирания Райса одного приёма, дБ
+     */
+    double fadingDb();
+
+   private:
+    struct Tag {
+        std::string name;
+        double x = 0;
+        double y = 0;
+        double phase = 0;               // для CIRCLE
+        double target_x = 0;            // для WAYPOINTS
+        double target_y = 0;
+        std::vector<double> shadow;     // затенение на каждый маяк
+    };
+
+    std::vector<message_objects::BLEBeacon> beacons_;
+    GeneratorOptions options_;
+    std::vector<Tag> tags_;
+    double time_ = 0;
+    std::uint32_t step_ = 0;            // номер объявления (seq) при нескольких шлюзах
+    std::vector<std::string> gateway_names_;
+
+    double min_x_ = 0, min_y_ = 0, max_x_ = 0, max_y_ = 0;
+
+    std::mt19937_64 rng_;
+    std::normal_distribution<double> normal_{0.0, 1.0};
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+
+    void move(Tag& tag, double dt);
+
+    void pickWaypoint(Tag& tag);
+};
+
+}  // namespace simulator
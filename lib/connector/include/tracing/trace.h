@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace tracing {
+
+/**
+ * Трассировка пути объявление -> позиция -> точка на экране.
+ *
+ * Каждый этап пишет интервал [начало, конец] в кольцевой буфер своего
+ * потока (последние kEventsPerThread событий, старые затираются), отметки
+ * времени - счётчик TSC. Позиция получает id в SOLVE; по нему EMIT,
+ * MODEL_APPEND и SCENE_PAINT связываются стрелками (flow events) в
+ * chrome://tracing / Perfetto. Выключенная трассировка стоит одной
+ * relaxed-загрузки на этап.
+ */
+
+enum class Stage : std::uint8_t {
+    RECEIVE,        // поток Paho: сообщение -> обработчик топика
+    ENQUEUE,        // запись измерения в очередь шарда
+    TICK,           // такт обработки целиком
+    SOLVE,          // навигатор для одной метки
+    EMIT,           // сигнал addPathPoint и публикация позиции
+    MODEL_APPEND,   // Model::addPointsToPath в потоке GUI
+    SCENE_UPDATE,   // обновление элементов сцены
+    SCENE_PAINT,    // отрисовка QGraphicsView
+};
+
+inline constexpr std::size_t kEventsPerThread = 8192;
+
+inline std::atomic<bool> g_enabled{false};
+
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+/**
+ * Отметка времени: TSC на x86, иначе steady_clock в наносекундах
+ */
+inline std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * Запись интервала этапа
+ * @param id Позиция, к которой относится этап (0 - без привязки)
+ * @param tag Метка устройства, обрезается до 15 символов
+ */
+void record(Stage stage, std::uint64_t start, std::uint64_t end,
+            std::uint64_t id = 0, std::string_view tag = {});
+
+/**
+ * Новый id позиции
+ */
+std::uint64_t nextId();
+
+/**
+ * id позиции, которую сейчас отдаёт этот поток: прямые обработчики
+ * сигнала (PositionBatcher) забирают его вместе с координатами
+ */
+std::uint64_t currentId();
+
+void setCurrentId(std::uint64_t id);
+
+/**
+ * Интервал от создания до разрушения
+ */
+class Span {
+   public:
+    explicit Span(Stage stage, std::uint64_t id = 0, std::string_view tag = {})
+        : stage_(stage), id_(id), tag_(tag), start_(enabled() ? now() : 0) {}
+
+    ~Span() {
+        if (start_) record(stage_, start_, now(), id_, tag_);
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+   private:
+    Stage stage_;
+    std::uint64_t id_;
+    std::string_view tag_;
+    std::uint64_t start_;
+};
+
+/**
+ * Все буферы в формате Chrome trace-event JSON; запись при этом
+ * не останавливается, события, переписанные во время чтения, пропускаются
+ */
+std::string chromeTrace();
+
+/**
+ * chromeTrace() в файл
+ * @return false если файл не открылся
+ */
+bool dumpChromeTrace(const std::string& path);
+
+}  // namespace tracing
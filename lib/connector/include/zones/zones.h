@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zones {
+
+/**
+ * Зоны (комнаты, запретные области) и события входа, выхода и
+ * пребывания меток в них.
+ *
+ * Многоугольники собираются в равномерную сетку: ячейка хранит зоны, чья
+ * рамка её задевает, у каждой зоны - свой непрерывный список рёбер. На
+ * позицию проверяются только зоны её ячейки и зоны, в которых метка уже
+ * числится. Дребезг на границе гасят полоса гистерезиса (выход - только
+ * дальше hysteresis_m от границы) и подтверждение несколькими позициями.
+ */
+
+struct Point {
+    double x = 0;
+    double y = 0;
+};
+
+struct Zone {
+    std::string name;
+    std::vector<Point> polygon;     // вершины по порядку, без повтора первой
+    double dwell_s = 0;             // событие DWELL после стольких секунд внутри, 0 - нет
+};
+
+struct ZoneOptions {
+    double hysteresis_m = 0.5;      // выход - только дальше этого от границы
+    int confirm_updates = 2;        // позиций подряд для входа и для выхода
+    double cell_size = 0;           // шаг сетки, м; 0 - по среднему размеру зон
+};
+
+enum class EventType : std::uint8_t { ENTER, EXIT, DWELL };
+
+const char* eventName(EventType type);
+
+struct ZoneEvent {
+    EventType type;
+    std::string tag;
+    std::string zone;
+    double x = 0;
+    double y = 0;
+    std::int64_t timestamp_ms = 0;
+    std::int64_t inside_ms = 0;     // для EXIT и DWELL: сколько метка внутри
+};
+
+/**
+ * {"event":"enter","tag":..,"zone":..,"x":..,"y":..,"ts":..,"inside_ms":..}
+ */
+std::string encodeJson(const ZoneEvent& event);
+
+/**
+ * Неизменяемый набор зон с сеткой; строится один раз на setZones
+ */
+class ZoneIndex {
+   public:
+    ZoneIndex(std::vector<Zone> zones, const ZoneOptions& options);
+
+    const std::vector<Zone>& zones() const { return zones_; }
+
+    const ZoneOptions& options() const { return options_; }
+
+    /**
+     * Зоны, чья рамка задевает ячейку точки, без повторов
+     * @return Указатель на номера зон и их число
+     */
+    std::pair<const std::uint32_t*, std::size_t> candidates(double x, double y) const;
+
+    bool contains(std::uint32_t zone, double x, double y) const;
+
+    /**
+     * Расстояние от точки до ближайшего ребра зоны
+     */
+    double distanceToBoundary(std::uint32_t zone, double x, double y) const;
+
+   private:
+    struct Edge {
+        double x0, y0, x1, y1;
+        double dx_dy;               // для пересечения с горизонталью точки
+    };
+
+    struct Bounds {
+        double min_x, min_y, max_x, max_y;
+    };
+
+    std::vector<Zone> zones_;
+    ZoneOptions options_;
+    std::vector<Bounds> bounds_;
+    std::vector<Edge> edges_;
+    std::vector<std::uint32_t> edge_start_;  // рёбра зоны i: [edge_start_[i], edge_start_[i+1])
+
+    // сетка в CSR: зоны ячейки c - cell_zones_[cell_start_[c] .. cell_start_[c+1])
+    double origin_x_ = 0;
+    double origin_y_ = 0;
+    double cell_ = 1;
+    std::int64_t columns_ = 0;
+    std::int64_t rows_ = 0;
+    std::vector<std::uint32_t> cell_start_;
+    std::vector<std::uint32_t> cell_zones_;
+};
+
+/**
+ * Состояние меток относительно зон. update() вызывается из одного потока
+ * (такт навигации), setZones() - из любого.
+ */
+class ZoneEngine {
+   public:
+    /**
+     * Новый набор зон; состояние меток сбрасывается без событий выхода
+     */
+    void setZones(std::vector<Zone> zones, const ZoneOptions& options = {});
+
+    std::shared_ptr<const ZoneIndex> index() const;
+
+    /**
+     * Новая позиция метки
+     * @param events Сюда дописываются события
+     * @return Число новых событий
+     */
+    std::size_t update(const std::string& tag, double x, double y, std::int64_t now_ms,
+                       std::vector<ZoneEvent>& events);
+
+    /**
+     * Забывает метки без позиций дольше idle_ms. Для подтверждённых зон
+     * забытой метки пишутся события EXIT в её последней точке
+     * @param events Сюда дописываются события
+     * @return Число забытых меток
+     */
+    std::size_t evictIdle(std::int64_t now_ms, std::int64_t idle_ms,
+                          std::vector<ZoneEvent>& events);
+
+    std::size_t tagCount() const { return tags_.size(); }
+
+    /**
+     * Сколько зон проверено точно в последнем update() (для метрик)
+     */
+    std::size_t lastTested() const { return last_tested_; }
+
+   private:
+    struct Tracked {
+        std::uint32_t zone;
+        bool inside;                // вход подтверждён
+        int streak;                 // позиций подряд за смену состояния
+        std::int64_t entered_ms;
+        bool dwelled;
+    };
+
+    struct TagState {
+        std::shared_ptr<const ZoneIndex> index;  // по какому набору зон состояние
+        std::vector<Tracked> zones;
+        double x = 0;               // последняя позиция
+        double y = 0;
+        std::int64_t seen_ms = 0;
+    };
+
+    std::atomic<std::shared_ptr<const ZoneIndex>> index_;
+    std::unordered_map<std::string, TagState> tags_;
+    std::size_t last_tested_ = 0;
+};
+
+}  // namespace zones
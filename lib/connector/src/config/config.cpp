@@ -40,3 +40,77 @@ std::vector<message_objects::BLEBeacon> ConfigReader::readBeacons() const {
 
     return beacons;
 }
+
+namespace {
+
+std::string trim(const std::string &value) {
+    const auto first = value.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return {};
+    const auto last = value.find_last_not_of(" \t\r");
+    return value.substr(first, last - first + 1);
+}
+
+}  // namespace
+
+std::vector<zones::Zone> ConfigReader::readZones() const {
+    std::vector<zones::Zone> result;
+
+    std::ifstream file(filePath_);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось открыть файл зон: " + filePath_);
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') continue;
+
+        std::stringstream ss(line);
+        std::string field;
+        zones::Zone zone;
+        if (!std::getline(ss, zone.name, ';')) continue;
+        if (!std::getline(ss, field, ';')) continue;
+
+        try {
+            zone.dwell_s = std::stod(field);
+            while (std::getline(ss, field, ';')) {
+                const auto comma = field.find(',');
+                if (comma == std::string::npos) {
+                    throw std::invalid_argument(field);
+                }
+                zone.polygon.push_back(
+                    {std::stod(field.substr(0, comma)), std::stod(field.substr(comma + 1))});
+            }
+        } catch (const std::exception&) {
+            // как и у маяков: строку с ошибкой пропускаем
+            continue;
+        }
+        if (zone.polygon.size() >= 3) {
+            result.push_back(std::move(zone));
+        }
+    }
+
+    return result;
+}
+
+std::map<std::string, std::string> ConfigReader::readSettings() const {
+    std::map<std::string, std::string> settings;
+
+    std::ifstream file(filePath_);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось открыть файл конфигурации: " + filePath_);
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') continue;
+
+        const auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+
+        settings[trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+    }
+
+    return settings;
+}
@@ -0,0 +1,284 @@
+#include "logging/log.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+namespace {
+
+constexpr std::size_t kRingSize = 512;  // строк на поток, степень двойки
+
+std::atomic<int> g_burst{LogOptions().burst_per_second};
+
+struct Record {
+    std::int64_t timestamp_us;
+    Level level;
+    const char* component;
+    std::uint32_t thread;
+    std::uint16_t size;
+    char text[LineWriter::kCapacity];
+};
+
+/**
+ * Кольцевой буфер одного потока: пишет только этот поток,
+ * читает только поток вывода
+ */
+struct ThreadBuffer {
+    std::uint32_t id = 0;
+    alignas(64) std::atomic<std::uint64_t> head{0};
+    alignas(64) std::atomic<std::uint64_t> tail{0};
+    std::atomic<bool> retired{false};  // поток завершился
+    std::array<Record, kRingSize> records;
+};
+
+class Sink {
+   public:
+    static Sink& instance() {
+        // не разрушается: потоки Paho могут писать и во время выхода
+        static Sink* sink = [] {
+            auto* created = new Sink();
+            std::atexit([] { Sink::instance().stop(); });
+            return created;
+        }();
+        return *sink;
+    }
+
+    std::shared_ptr<ThreadBuffer> registerThread() {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->id = next_thread_id_++;
+        buffers_.push_back(buffer);
+        if (!thread_.joinable() && !stopped_) {
+            thread_ = std::thread(&Sink::run, this);
+        }
+        return buffer;
+    }
+
+    void configure(const LogOptions& options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (out_ != stderr) std::fclose(out_);
+        out_ = stderr;
+        if (!options.file.empty()) {
+            if (FILE* file = std::fopen(options.file.c_str(), "a")) {
+                out_ = file;
+            } else {
+                std::fprintf(stderr, "Cannot open log file %s\n", options.file.c_str());
+            }
+        }
+        interval_ = std::chrono::milliseconds(std::max(1, options.flush_interval_ms));
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) return;
+        const std::uint64_t target = ++flush_requested_;
+        wake_.notify_one();
+        flushed_cv_.wait(lock, [&] { return flushed_ >= target || stopped_; });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) return;
+            stopped_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) thread_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain();
+        flushed_cv_.notify_all();
+    }
+
+    std::atomic<std::uint64_t> dropped{0};
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_cv_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::vector<Record> batch_;
+    std::string line_;
+    std::thread thread_;
+    FILE* out_ = stderr;
+    std::chrono::milliseconds interval_{LogOptions().flush_interval_ms};
+    std::uint32_t next_thread_id_ = 0;
+    std::uint64_t flush_requested_ = 0;
+    std::uint64_t flushed_ = 0;
+    bool stopped_ = false;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_) {
+            wake_.wait_for(lock, interval_,
+                           [&] { return stopped_ || flush_requested_ > flushed_; });
+            const std::uint64_t requested = flush_requested_;
+            drain();
+            flushed_ = requested;
+            flushed_cv_.notify_all();
+        }
+    }
+
+    // под mutex_
+    void drain() {
+        batch_.clear();
+        for (auto it = buffers_.begin(); it != buffers_.end();) {
+            ThreadBuffer& buffer = **it;
+            // retired читается до head: всё записанное до выхода потока видно
+            const bool retired = buffer.retired.load(std::memory_order_acquire);
+            const std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+            std::uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+            for (; tail != head; ++tail) {
+                batch_.push_back(buffer.records[tail % kRingSize]);
+            }
+            buffer.tail.store(tail, std::memory_order_release);
+            it = retired ? buffers_.erase(it) : it + 1;
+        }
+        if (batch_.empty()) return;
+
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Record& a, const Record& b) {
+                             return a.timestamp_us < b.timestamp_us;
+                         });
+        for (const auto& record : batch_) {
+            format(record);
+            std::fwrite(line_.data(), 1, line_.size(), out_);
+        }
+        std::fflush(out_);
+    }
+
+    void format(const Record& record) {
+        const std::time_t seconds = record.timestamp_us / 1000000;
+        std::tm tm{};
+        gmtime_r(&seconds, &tm);
+        char stamp[40];
+        const std::size_t n = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+        std::snprintf(stamp + n, sizeof(stamp) - n, ".%06dZ",
+                      static_cast<int>(record.timestamp_us % 1000000));
+
+        line_.assign("ts=").append(stamp);
+        line_.append(" level=").append(levelName(record.level));
+        line_.append(" component=").append(record.component);
+        line_.append(" thread=").append(std::to_string(record.thread));
+        line_.append(" ").append(record.text, record.size);
+        line_.append("\n");
+    }
+};
+
+struct ThreadHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ~ThreadHolder() {
+        if (buffer) buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadHolder t_holder;
+
+}  // namespace
+
+const char* levelName(Level level) {
+    switch (level) {
+        case Level::TRACE: return "trace";
+        case Level::DEBUG: return "debug";
+        case Level::INFO: return "info";
+        case Level::WARN: return "warn";
+        case Level::ERROR: return "error";
+    }
+    return "?";
+}
+
+bool parseLevel(std::string_view name, Level& level) {
+    for (int i = static_cast<int>(Level::TRACE); i <= static_cast<int>(Level::ERROR); ++i) {
+        if (name == levelName(static_cast<Level>(i))) {
+            level = static_cast<Level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void configure(const LogOptions& options) {
+    g_level.store(static_cast<int>(options.level), std::memory_order_relaxed);
+    g_burst.store(std::max(1, options.burst_per_second), std::memory_order_relaxed);
+    Sink::instance().configure(options);
+}
+
+void flush() {
+    Sink::instance().flush();
+}
+
+std::uint64_t dropped() {
+    return Sink::instance().dropped.load(std::memory_order_relaxed);
+}
+
+std::int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+bool RateLimiter::acquire(std::int64_t now_ms, std::uint32_t& suppressed) {
+    std::int64_t start = window_start_.load(std::memory_order_relaxed);
+    if (now_ms - start >= 1000 &&
+        window_start_.compare_exchange_strong(start, now_ms,
+                                              std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+    const auto burst = static_cast<std::uint32_t>(g_burst.load(std::memory_order_relaxed));
+    if (count_.fetch_add(1, std::memory_order_relaxed) < burst) return true;
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void LineWriter::quoted(std::string_view text, bool always) {
+    const bool quote = always || text.empty() ||
+                       text.find_first_of(" =\"\\\n\t") != std::string_view::npos;
+    if (!quote) {
+        append(text);
+        return;
+    }
+    append("\"");
+    for (char c : text) {
+        if (size_ + 3 > kCapacity) break;  // место под экранирование и кавычку
+        switch (c) {
+            case '"': append("\\\""); break;
+            case '\\': append("\\\\"); break;
+            case '\n': append("\\n"); break;
+            default: data_[size_++] = c;
+        }
+    }
+    append("\"");
+}
+
+void submit(Level level, const char* component, std::int64_t timestamp_us,
+            const LineWriter& line) {
+    auto& holder = t_holder;
+    if (!holder.buffer) holder.buffer = Sink::instance().registerThread();
+    ThreadBuffer& buffer = *holder.buffer;
+
+    const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= kRingSize) {
+        Sink::instance().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record& record = buffer.records[head % kRingSize];
+    record.timestamp_us = timestamp_us;
+    record.level = level;
+    record.component = component;
+    record.thread = buffer.id;
+    const auto text = line.view();
+    record.size = static_cast<std::uint16_t>(text.size());
+    std::memcpy(record.text, text.data(), text.size());
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+}  // namespace logging
@@ -0,0 +1,265 @@
+#include "metrics/exporter.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "logging/log.h"
+
+namespace metrics {
+
+namespace {
+
+constexpr std::size_t kMaxRequestBytes = 8 * 1024;
+constexpr int kClientTimeoutSec = 2;
+
+std::string escapeHelp(const std::string& help) {
+    std::string out;
+    out.reserve(help.size());
+    for (char c : help) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::string formatValue(double value) {
+    if (value == std::floor(value) && std::abs(value) < 1e18) {
+        return std::to_string(static_cast<std::int64_t>(value));
+    }
+    std::ostringstream out;
+    out.precision(17);
+    out << value;
+    return out.str();
+}
+
+void writeHistogram(std::ostringstream& out, const std::string& name,
+                    const HistogramSnapshot& h) {
+    // корзины снимка выровнены по степеням двойки, поэтому суммы точные
+    auto bucket = h.buckets.begin();
+    std::uint64_t cumulative = 0;
+    for (int k = 0; k <= Histogram::kMaxBits; ++k) {
+        const std::uint64_t le = (std::uint64_t{1} << k) - 1;
+        while (bucket != h.buckets.end() && bucket->first <= le) {
+            cumulative += bucket->second;
+            ++bucket;
+        }
+        out << name << "_bucket{le=\"" << le << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket{le=\"+Inf\"} " << h.count << "\n";
+    out << name << "_sum " << h.sum << "\n";
+    out << name << "_count " << h.count << "\n";
+}
+
+bool sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n =
+            ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+std::string response(const std::string& status, const std::string& type,
+                     const std::string& body, bool head) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << status << "\r\n"
+        << "Content-Type: " << type << "\r\n"
+        << "Content-Length: " << body.size() << "\r\n"
+        << "Connection: close\r\n\r\n";
+    if (!head) out << body;
+    return out.str();
+}
+
+}  // namespace
+
+std::string formatPrometheus(const Registry& registry) {
+    std::ostringstream out;
+    for (const auto& metric : registry.snapshot()) {
+        out << "# HELP " << metric.name << " " << escapeHelp(metric.help) << "\n";
+        switch (metric.type) {
+            case MetricType::COUNTER:
+                out << "# TYPE " << metric.name << " counter\n"
+                    << metric.name << " " << static_cast<std::uint64_t>(metric.value)
+                    << "\n";
+                break;
+            case MetricType::GAUGE:
+                out << "# TYPE " << metric.name << " gauge\n"
+                    << metric.name << " " << formatValue(metric.value) << "\n";
+                break;
+            case MetricType::HISTOGRAM:
+                out << "# TYPE " << metric.name << " histogram\n";
+                writeHistogram(out, metric.name, metric.histogram);
+                break;
+        }
+    }
+    return out.str();
+}
+
+Exporter::Exporter(const Registry& registry, ExporterOptions options)
+    : registry_(registry), options_(std::move(options)) {}
+
+Exporter::~Exporter() {
+    stop();
+}
+
+void Exporter::addHandler(const std::string& path, const std::string& content_type,
+                          std::function<std::string()> body) {
+    handlers_[path] = {content_type, std::move(body)};
+}
+
+bool Exporter::start() {
+    if (isRunning()) return true;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo* addresses = nullptr;
+    const std::string port = std::to_string(options_.port);
+    const int rc = ::getaddrinfo(
+        options_.bind_address.empty() ? nullptr : options_.bind_address.c_str(),
+        port.c_str(), &hints, &addresses);
+    if (rc != 0) {
+        BACON_LOG_ERROR("metrics", "cannot resolve address", "address",
+                        options_.bind_address, "error", ::gai_strerror(rc));
+        return false;
+    }
+
+    int error = 0;
+    for (auto* address = addresses; address; address = address->ai_next) {
+        const int fd = ::socket(address->ai_family,
+                                address->ai_socktype | SOCK_CLOEXEC,
+                                address->ai_protocol);
+        if (fd < 0) {
+            error = errno;
+            continue;
+        }
+        const int reuse = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (::bind(fd, address->ai_addr, address->ai_addrlen) == 0 &&
+            ::listen(fd, 16) == 0) {
+            listen_fd_ = fd;
+            break;
+        }
+        error = errno;
+        ::close(fd);
+    }
+    ::freeaddrinfo(addresses);
+
+    if (listen_fd_ < 0) {
+        BACON_LOG_ERROR("metrics", "cannot listen", "address", options_.bind_address,
+                        "port", options_.port, "error", std::strerror(error));
+        return false;
+    }
+    if (::pipe2(wake_fds_, O_CLOEXEC) != 0) {
+        BACON_LOG_ERROR("metrics", "pipe failed", "error", std::strerror(errno));
+        closeSockets();
+        return false;
+    }
+
+    sockaddr_storage bound{};
+    socklen_t length = sizeof(bound);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bound), &length);
+    bound_port_ = ntohs(bound.ss_family == AF_INET6
+                            ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                            : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+
+    thread_ = std::thread(&Exporter::serve, this);
+    return true;
+}
+
+void Exporter::stop() {
+    if (!thread_.joinable()) return;
+    const char wake = 1;
+    while (::write(wake_fds_[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    closeSockets();
+}
+
+void Exporter::closeSockets() {
+    for (int* fd : {&listen_fd_, &wake_fds_[0], &wake_fds_[1]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void Exporter::serve() {
+    pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}};
+    while (true) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            BACON_LOG_ERROR("metrics", "poll failed", "error", std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        const int client = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        handle(client);
+        ::close(client);
+    }
+}
+
+void Exporter::handle(int client_fd) {
+    // медленный клиент не должен держать поток дольше таймаута
+    timeval timeout{kClientTimeoutSec, 0};
+    ::setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < kMaxRequestBytes) {
+        const ssize_t n = ::recv(client_fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    // строка запроса: метод, путь, версия
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    const std::string path = target.substr(0, target.find('?'));
+    const bool head = method == "HEAD";
+
+    if (method != "GET" && !head) {
+        sendAll(client_fd, response("405 Method Not Allowed", "text/plain",
+                                    "Method not allowed\n", false));
+    } else if (path == "/metrics") {
+        scrapes_.fetch_add(1, std::memory_order_relaxed);
+        sendAll(client_fd, response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                    formatPrometheus(registry_), head));
+    } else if (auto handler = handlers_.find(path); handler != handlers_.end()) {
+        sendAll(client_fd, response("200 OK", handler->second.content_type,
+                                    handler->second.body(), head));
+    } else if (path == "/") {
+        sendAll(client_fd,
+                response("200 OK", "text/html",
+                         "<html><body><a href=\"/metrics\">Metrics</a></body></html>\n",
+                         head));
+    } else {
+        sendAll(client_fd, response("404 Not Found", "text/plain", "Not found\n", head));
+    }
+}
+
+}  // namespace metrics
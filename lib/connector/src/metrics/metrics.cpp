@@ -0,0 +1,176 @@
+#include "metrics/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace metrics {
+
+std::size_t threadShard() {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t shard =
+        next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+std::uint64_t Counter::value() const {
+    std::uint64_t total = 0;
+    for (const auto& cell : cells_) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::uint64_t HistogramSnapshot::percentile(double q) const {
+    if (count == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(
+        std::ceil(std::clamp(q, 0.0, 1.0) * double(count)));
+    std::uint64_t seen = 0;
+    for (const auto& [upper, n] : buckets) {
+        seen += n;
+        if (seen >= std::max<std::uint64_t>(rank, 1)) return std::min(upper, max);
+    }
+    return max;
+}
+
+std::uint64_t Histogram::bucketUpperBound(std::size_t index) {
+    if (index < kSubBuckets) return index;
+    if (index >= kBuckets - 1) return UINT64_MAX;  // переполнение, от 2^kMaxBits
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    const std::uint64_t sub = kSubBuckets + index % kSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot result;
+    std::array<std::uint64_t, kBuckets> counts{};
+    for (const auto& shard : shards_) {
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+        result.sum += shard.sum.load(std::memory_order_relaxed);
+        result.max = std::max(result.max, shard.max.load(std::memory_order_relaxed));
+    }
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        if (counts[i] == 0) continue;
+        result.count += counts[i];
+        result.buckets.emplace_back(bucketUpperBound(i), counts[i]);
+    }
+    return result;
+}
+
+Registry::Entry* Registry::find(const std::string& name, MetricType type) {
+    for (auto& entry : entries_) {
+        if (entry.name != name) continue;
+        if (entry.type != type) {
+            throw std::invalid_argument("Metric " + name +
+                                        " is already registered with another type");
+        }
+        return &entry;
+    }
+    return nullptr;
+}
+
+Counter& Registry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto* entry = find(name, MetricType::COUNTER)) return *entry->counter;
+    auto& entry = entries_.emplace_back();
+    entry.name = name;
+    entry.help = help;
+    entry.type = MetricType::COUNTER;
+    entry.counter = std::make_unique<Counter>();
+    return *entry.counter;
+}
+
+Gauge& Registry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto* entry = find(name, MetricType::GAUGE)) {
+        if (!entry->gauge) {
+            throw std::invalid_argument("Metric " + name + " is a computed gauge");
+        }
+        return *entry->gauge;
+    }
+    auto& entry = entries_.emplace_back();
+    entry.name = name;
+    entry.help = help;
+    entry.type = MetricType::GAUGE;
+    entry.gauge = std::make_unique<Gauge>();
+    return *entry.gauge;
+}
+
+void Registry::gauge(const std::string& name, const std::string& help,
+                     std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* entry = find(name, MetricType::GAUGE);
+    if (entry && entry->gauge) {
+        // на этот Gauge уже есть ссылки, удалять его нельзя
+        throw std::invalid_argument("Metric " + name + " is a plain gauge");
+    }
+    if (!entry) {
+        entry = &entries_.emplace_back();
+        entry->name = name;
+        entry->help = help;
+        entry->type = MetricType::GAUGE;
+    }
+    entry->read = std::move(read);
+}
+
+Histogram& Registry::histogram(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto* entry = find(name, MetricType::HISTOGRAM)) return *entry->histogram;
+    auto& entry = entries_.emplace_back();
+    entry.name = name;
+    entry.help = help;
+    entry.type = MetricType::HISTOGRAM;
+    entry.histogram = std::make_unique<Histogram>();
+    return *entry.histogram;
+}
+
+std::vector<MetricSnapshot> Registry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MetricSnapshot> result;
+    result.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        MetricSnapshot metric;
+        metric.name = entry.name;
+        metric.help = entry.help;
+        metric.type = entry.type;
+        switch (entry.type) {
+            case MetricType::COUNTER:
+                metric.value = static_cast<double>(entry.counter->value());
+                break;
+            case MetricType::GAUGE:
+                metric.value = entry.gauge ? static_cast<double>(entry.gauge->value())
+                                           : entry.read();
+                break;
+            case MetricType::HISTOGRAM:
+                metric.histogram = entry.histogram->snapshot();
+                break;
+        }
+        result.push_back(std::move(metric));
+    }
+    return result;
+}
+
+std::string Registry::format(const std::string& indent) const {
+    std::ostringstream out;
+    for (const auto& metric : snapshot()) {
+        out << indent << metric.name << ": ";
+        if (metric.type == MetricType::HISTOGRAM) {
+            const auto& h = metric.histogram;
+            out << "count " << h.count << ", mean "
+                << static_cast<std::uint64_t>(std::llround(h.mean())) << ", p50 "
+                << h.percentile(0.5) << ", p99 " << h.percentile(0.99) << ", max "
+                << h.max;
+        } else if (metric.value == std::floor(metric.value)) {
+            out << static_cast<std::int64_t>(metric.value);
+        } else {
+            out << metric.value;
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace metrics
@@ -0,0 +1,155 @@
+#include "mqtt_connector/advert_dedup.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <string_view>
+
+namespace mqtt_connector {
+
+namespace {
+
+// финализатор splitmix64: равномерные младшие и старшие биты
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+std::uint64_t hashString(const std::string& value) {
+    return std::hash<std::string_view>{}(value);
+}
+
+// запись жива, пока её срок впереди; сравнение переживает переполнение
+bool alive(std::uint32_t expires, std::uint32_t now) {
+    return static_cast<std::int32_t>(expires - now) > 0;
+}
+
+}  // namespace
+
+AdvertDeduplicator::AdvertDeduplicator(int window_ms, std::size_t capacity)
+    : window_ms_(static_cast<std::uint32_t>(std::max(1, window_ms))),
+      mask_(std::bit_ceil(std::max<std::size_t>(kMaxProbe, capacity / kStripes)) - 1) {
+    for (auto& stripe : stripes_) {
+        stripe.entries.resize(mask_ + 1);
+    }
+}
+
+std::uint32_t AdvertDeduplicator::clockMs() const {
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - start_)
+                                          .count());
+}
+
+AdvertDeduplicator::Verdict AdvertDeduplicator::check(
+    const message_objects::BLEBeaconState& state, std::uint32_t generation,
+    std::uint32_t now) {
+    if (state.seq_ == 0) {
+        return Verdict::ACCEPT;
+    }
+    // 0 - признак свободной записи
+    const std::uint64_t advert =
+        mix(hashString(state.tag_) ^ mix(hashString(state.name_) ^ state.seq_)) | 1;
+    const std::uint64_t copy = mix(advert ^ hashString(state.gateway_)) | 1;
+
+    Stripe& stripe = stripes_[advert >> 60];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+    bool found = false;
+    find(stripe, copy, now, found);
+    if (found) {
+        return Verdict::DUPLICATE;
+    }
+    Entry* entry = find(stripe, advert, now, found);
+    if (found) {
+        if (entry->generation != generation) {
+            return Verdict::LATE;
+        }
+    } else {
+        *entry = {advert, now + window_ms_, generation};
+    }
+    // слот копии ищется заново: он мог совпасть со слотом объявления
+    entry = find(stripe, copy, now, found);
+    *entry = {copy, now + window_ms_, generation};
+    return Verdict::ACCEPT;
+}
+
+void AdvertDeduplicator::clear() {
+    for (auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        std::fill(stripe.entries.begin(), stripe.entries.end(), Entry());
+    }
+}
+
+AdvertDeduplicator::Entry* AdvertDeduplicator::find(Stripe& stripe, std::uint64_t key,
+                                                    std::uint32_t now, bool& found) {
+    Entry* victim = nullptr;
+    // младший бит ключа всегда 1 (0 - признак свободной записи), слот
+    // берётся по остальным битам, иначе чётные слоты доступны только пробой
+    const std::uint64_t slot = key >> 1;
+    for (std::size_t i = 0; i < kMaxProbe; ++i) {
+        Entry& entry = stripe.entries[(slot + i) & mask_];
+        const bool live = entry.key != 0 && alive(entry.expires, now);
+        if (live && entry.key == key) {
+            found = true;
+            return &entry;
+        }
+        // свободная или просроченная запись, иначе - самая старая
+        if (!live) {
+            if (!victim || alive(victim->expires, now)) victim = &entry;
+        } else if (!victim || (alive(victim->expires, now) &&
+                               static_cast<std::int32_t>(entry.expires - victim->expires) < 0)) {
+            victim = &entry;
+        }
+    }
+    found = false;
+    return victim;
+}
+
+std::size_t fuseGatewayCopies(std::vector<message_objects::BLEBeaconState>& states) {
+    if (states.size() < 2 ||
+        std::none_of(states.begin(), states.end(),
+                     [](const auto& state) { return state.seq_ != 0; })) {
+        return 0;
+    }
+
+    // суммарная мощность (мВт) и число копий каждого оставшегося измерения
+    std::vector<std::pair<double, int>> power(states.size());
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        std::size_t match = kept;
+        if (states[i].seq_ != 0) {
+            // копии приходят рядом: ищем с конца
+            for (std::size_t j = kept; j-- > 0;) {
+                if (states[j].seq_ == states[i].seq_) {
+                    match = j;
+                    break;
+                }
+            }
+        }
+        const double milliwatts = std::pow(10.0, states[i].rssi_ / 10.0);
+        if (match == kept) {
+            if (i != kept) states[kept] = std::move(states[i]);
+            power[kept] = {milliwatts, 1};
+            ++kept;
+        } else {
+            power[match].first += milliwatts;
+            ++power[match].second;
+        }
+    }
+    for (std::size_t j = 0; j < kept; ++j) {
+        if (power[j].second > 1) {
+            states[j].rssi_ = static_cast<int>(
+                std::lround(10.0 * std::log10(power[j].first / power[j].second)));
+        }
+    }
+    const std::size_t removed = states.size() - kept;
+    states.erase(states.begin() + static_cast<std::ptrdiff_t>(kept), states.end());
+    return removed;
+}
+
+}  // namespace mqtt_connector
@@ -1,147 +1,168 @@
 #include "mqtt_connector/connection_manager.h"
-#include "message_objects/BLE.h"
 #include "mqtt_connector/mqtt_client.h"
 
 #include <mqtt/async_client.h>
 #include <mqtt/callback.h>
 #include <mqtt/ssl_options.h>
+#include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <functional>
 
-#include <json.hpp>
+#include "logging/log.h"
 
-#include <iostream>
+namespace mqtt_connector {
 
+/**
+ * @brief Callback Paho MQTT: входящие сообщения и потеря соединения
+ */
 class Callback : public virtual mqtt::callback {
-
    public:
-    explicit Callback(mqtt_connector::MqttClient* mgr) : mgr_(mgr) {}
+    Callback(ConnectionManager* manager, MqttClient* mgr)
+        : manager_(manager), mgr_(mgr) {}
 
     void message_arrived(mqtt::const_message_ptr msg) override {
-        // std::ofstream out;
-
-        // out.open("TmpFile.txt", std::ios::app);
-        // out << "Message received: " << msg->get_payload_str() << "\n";
-        // out.close();
-
         if (!mgr_)
             return;
 
-        try {
-            nlohmann::json json_data =
-                nlohmann::json::parse(msg->get_payload_str());
-
-            if (!mgr_->BLEBeaconContains(json_data["name"]))
-                return;
-
-            message_objects::BLEBeaconState state;
-            state.name_ = json_data["name"];
-            state.txPower_ = json_data["tx_power"];
-            state.rssi_ = json_data["rssi"];
+        // разбор по топику делает MessageHandler
+        Message message(msg->get_topic(), msg->get_payload_str(),
+                        msg->get_qos(), msg->is_retained());
+        message.shard = manager_->shard();
+        mgr_->onMessageReceived(message);
+    }
 
-            mgr_->addBLEBeaconState(json_data["name"], state);
-        } catch (const nlohmann::json::exception& e) {
-            std::cerr << "JSON parsing error: " << e.what() << std::endl;
+    void connection_lost(const std::string& cause) override {
+        if (manager_) {
+            manager_->setState(ConnectionState::DISCONNECTED);
+            manager_->handleError("Connection lost: " + cause);
+            manager_->onConnectionLost();
         }
     }
 
    private:
-    mqtt_connector::MqttClient* mgr_;
+    ConnectionManager* manager_;
+    MqttClient* mgr_;
 };
 
-namespace mqtt_connector {
-
 /**
- * @brief Внутренний callback класс для обработки событий Paho MQTT
+ * @brief Слушатель асинхронной операции Paho: результат приходит
+ * в потоке Paho, вызывающий поток не ждёт
  */
-class MqttCallback : public mqtt::callback {
+class ActionListener : public virtual mqtt::iaction_listener {
    public:
-    explicit MqttCallback(ConnectionManager* manager) : manager_(manager) {}
+    using Handler = std::function<void(const mqtt::token& tok)>;
 
-    void connection_lost(const std::string& cause) override {
-        if (manager_) {
-            manager_->setState(ConnectionState::DISCONNECTED);
-            manager_->handleError("Connection lost: " + cause);
+    ActionListener(Handler on_success, Handler on_failure)
+        : on_success_(std::move(on_success)),
+          on_failure_(std::move(on_failure)) {}
+
+    void on_success(const mqtt::token& tok) override {
+        if (on_success_) {
+            on_success_(tok);
         }
     }
 
-    void delivery_complete(mqtt::delivery_token_ptr tok) override {
-        // Обработка подтверждения доставки (если нужно)
+    void on_failure(const mqtt::token& tok) override {
+        if (on_failure_) {
+            on_failure_(tok);
+        }
     }
 
    private:
-    ConnectionManager* manager_;
+    Handler on_success_;
+    Handler on_failure_;
 };
 
 ConnectionManager::ConnectionManager()
     : connection_state_(ConnectionState::DISCONNECTED),
-      auto_reconnect_(false),
-      retry_interval_(5),
-      should_stop_(false) {
-    cb_ = nullptr;
+      session_present_(false),
+      auto_reconnect_(true),
+      should_stop_(false),
+      min_retry_interval_(ConnectionConfig{}.min_retry_interval_ms),
+      max_retry_interval_(ConnectionConfig{}.max_retry_interval_ms),
+      rng_(std::random_device{}()),
+      mgr_(nullptr) {
+    connect_listener_ = std::make_unique<ActionListener>(
+        [this](const mqtt::token& tok) {
+            if (!isCurrent(tok)) {
+                return;  // ответ снятого клиента: подписываться не на чем
+            }
+            {
+                std::lock_guard<std::mutex> lock(reconnect_mutex_);
+                reconnect_attempts_ = 0;
+            }
+            session_present_ = tok.get_connect_response().is_session_present();
+            setState(ConnectionState::CONNECTED);
+        },
+        [this](const mqtt::token& tok) {
+            if (!isCurrent(tok)) {
+                return;
+            }
+            handleError("Failed to connect: return code " +
+                        std::to_string(static_cast<int>(tok.get_return_code())));
+            setState(ConnectionState::FAILED);
+            scheduleReconnect();
+        });
+
+    reconnect_thread_ = std::thread(&ConnectionManager::reconnectLoop, this);
 }
 
 ConnectionManager::~ConnectionManager() {
-    disconnect();
-
-    should_stop_ = true;
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        should_stop_ = true;
+    }
+    reconnect_cv_.notify_all();
     if (reconnect_thread_.joinable()) {
         reconnect_thread_.join();
     }
 
-    if (cb_) {
-        delete cb_;
-        cb_ = nullptr;
-    }
+    disconnect();
 }
 
 bool ConnectionManager::connect(const ConnectionConfig& config) {
-    std::cout << "ConnectionManager::connect\n";
+    DetachedClient old;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        old = detachLocked();
+    }
+    closeDetached(std::move(old));
+
+    std::lock_guard<std::mutex> lock(client_mutex_);
     try {
         config_ = config;
+        auto_reconnect_ = config.auto_reconnect;
+        {
+            std::lock_guard<std::mutex> rlock(reconnect_mutex_);
+            min_retry_interval_ =
+                std::chrono::milliseconds(config.min_retry_interval_ms);
+            max_retry_interval_ =
+                std::chrono::milliseconds(config.max_retry_interval_ms);
+        }
 
         std::string server_uri = (config.use_ssl ? "ssl://" : "tcp://") +
                                  config.broker_host + ":" +
                                  std::to_string(config.broker_port);
 
+        // клиент живёт до смены настроек: при переподключении переиспользуется
+        // вместе с очередью неподтверждённых сообщений
         client_ =
             std::make_unique<mqtt::async_client>(server_uri, config.client_id);
 
-        // callback_ = std::make_unique<MqttCallback>(this);
-        // client_->set_callback(*callback_);
+        callback_ = std::make_unique<Callback>(this, mgr_);
+        client_->set_callback(*callback_);
 
-        // HardCode:
-        if (cb_) {
-            delete cb_;
-            cb_ = nullptr;
-        }
-        cb_ = new Callback(mgr_);
-        client_->set_callback(*cb_);
-
-        mqtt::connect_options connOpts;
-        connOpts.set_keep_alive_interval(config.keep_alive_interval);
-        connOpts.set_clean_session(config.clean_session);
-        std::cout << "CONNECTING\n";
+        conn_opts_ = std::make_unique<mqtt::connect_options>();
+        conn_opts_->set_keep_alive_interval(config.keep_alive_interval);
+        conn_opts_->set_clean_session(config.clean_session);
+        conn_opts_->set_connect_timeout(config.connection_timeout);
 
+        session_present_ = false;
         setState(ConnectionState::CONNECTING);
 
-        auto token = client_->connect(connOpts);
-        std::cout << config.connection_timeout << std::endl;
-        token->wait_for(std::chrono::seconds(config.connection_timeout));
-
-        if (token->get_return_code() == mqtt::ReasonCode::SUCCESS) {
-            setState(ConnectionState::CONNECTED);
-            std::cout << "CONNECTED\n";
-            return true;
-        } else {
-            handleError(
-                "Failed to connect: return code " +
-                std::to_string(static_cast<int>(token->get_return_code())));
-
-            std::cout << "FAILED\n";
-            setState(ConnectionState::FAILED);
-            return false;
-        }
+        // результат придёт в connect_listener_ из потока Paho
+        client_->connect(*conn_opts_, nullptr, *connect_listener_);
+        return true;
 
     } catch (const mqtt::exception& e) {
         handleError("MQTT exception: " + std::string(e.what()));
@@ -155,23 +176,47 @@ bool ConnectionManager::connect(const ConnectionConfig& config) {
 }
 
 void ConnectionManager::disconnect() {
+    DetachedClient old;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        old = detachLocked();
+    }
+    closeDetached(std::move(old));
+}
+
+ConnectionManager::DetachedClient ConnectionManager::detachLocked() {
+    cancelReconnect();
+    return {std::move(callback_), std::move(conn_opts_), std::move(client_)};
+}
+
+void ConnectionManager::closeDetached(DetachedClient old) {
+    if (!old.client) {
+        return;
+    }
     try {
-        if (client_ && client_->is_connected()) {
-            auto token = client_->disconnect();
-            token->wait();
+        if (old.client->is_connected()) {
+            // ожидание ограничено: вызывается не из GUI-потока
+            old.client->disconnect()->wait_for(
+                std::chrono::milliseconds(kDisconnectTimeoutMs));
         }
         setState(ConnectionState::DISCONNECTED);
     } catch (const std::exception& e) {
         handleError("Error during disconnect: " + std::string(e.what()));
     }
+}
 
-    client_.reset();
-    callback_.reset();
+bool ConnectionManager::isCurrent(const mqtt::token& tok) {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    return client_ && tok.get_client() == client_.get();
 }
 
 bool ConnectionManager::isConnected() const {
-    return connection_state_ == ConnectionState::CONNECTED && client_ &&
-           client_->is_connected();
+    // client_ не читаем: его меняют connect() и disconnect() под client_mutex_
+    return connection_state_ == ConnectionState::CONNECTED;
+}
+
+bool ConnectionManager::isSessionPresent() const {
+    return session_present_;
 }
 
 ConnectionState ConnectionManager::getConnectionState() const {
@@ -188,21 +233,48 @@ void ConnectionManager::setErrorCallback(ErrorCallback callback) {
     error_callback_ = std::move(callback);
 }
 
-mqtt::async_client* ConnectionManager::getClient() {
-    return client_.get();
+bool ConnectionManager::publish(const std::shared_ptr<mqtt::message>& message,
+                                void* context, mqtt::iaction_listener& listener) {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (!client_) {
+        return false;
+    }
+    client_->publish(message, context, listener);
+    return true;
+}
+
+bool ConnectionManager::subscribe(const std::string& topic, int qos) {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (!client_) {
+        return false;
+    }
+    client_->subscribe(topic, qos);
+    return true;
+}
+
+bool ConnectionManager::unsubscribe(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (!client_) {
+        return false;
+    }
+    client_->unsubscribe(topic);
+    return true;
 }
 
 void ConnectionManager::setAutoReconnect(bool enable, int retry_interval) {
     auto_reconnect_ = enable;
-    retry_interval_ = retry_interval;
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        max_retry_interval_ = std::max(min_retry_interval_,
+                                       std::chrono::milliseconds(
+                                           std::chrono::seconds(retry_interval)));
+    }
 
-    if (enable && !reconnect_thread_.joinable()) {
-        should_stop_ = false;
-        reconnect_thread_ =
-            std::thread(&ConnectionManager::reconnectLoop, this);
-    } else if (!enable && reconnect_thread_.joinable()) {
-        should_stop_ = true;
-        reconnect_thread_.join();
+    if (!enable) {
+        cancelReconnect();
+    } else if (connection_state_ == ConnectionState::DISCONNECTED ||
+               connection_state_ == ConnectionState::FAILED) {
+        scheduleReconnect();
     }
 }
 
@@ -214,13 +286,19 @@ std::string ConnectionManager::getLastError() const {
 void ConnectionManager::setState(ConnectionState state) {
     connection_state_ = state;
 
-    std::lock_guard<std::mutex> lock(state_mutex_);
-    if (connection_callback_) {
-        connection_callback_(state);
+    ConnectionCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        callback = connection_callback_;
+    }
+    // вызываем вне блокировки: обработчик может обращаться к менеджеру
+    if (callback) {
+        callback(state);
     }
 }
 
 void ConnectionManager::handleError(const std::string& error) {
+    BACON_LOG_WARN("mqtt", "connection error", "shard", shard_, "error", error);
     {
         std::lock_guard<std::mutex> lock(state_mutex_);
         last_error_ = error;
@@ -231,27 +309,89 @@ void ConnectionManager::handleError(const std::string& error) {
     }
 }
 
-void ConnectionManager::reconnectLoop() {
-    while (!should_stop_) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+void ConnectionManager::onConnectionLost() {
+    scheduleReconnect();
+}
 
-        if (should_stop_)
-            break;
+void ConnectionManager::scheduleReconnect() {
+    if (!auto_reconnect_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        if (reconnect_pending_ || should_stop_) {
+            return;
+        }
+        // предел растёт как min * 2^n, сама задержка - случайная внутри
+        const int shift = std::min(reconnect_attempts_, 16);
+        const std::chrono::milliseconds ceiling = std::min(
+            max_retry_interval_,
+            min_retry_interval_ * (std::chrono::milliseconds::rep{1} << shift));
+        std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(
+            min_retry_interval_.count(),
+            std::max(min_retry_interval_, ceiling).count());
+
+        ++reconnect_attempts_;
+        const std::chrono::milliseconds delay(jitter(rng_));
+        reconnect_at_ = std::chrono::steady_clock::now() + delay;
+        reconnect_pending_ = true;
+        BACON_LOG_INFO("mqtt", "reconnect scheduled", "shard", shard_, "attempt",
+                       reconnect_attempts_, "delay_ms", delay.count());
+    }
+    reconnect_cv_.notify_one();
+}
 
-        if (auto_reconnect_ &&
-            (connection_state_ == ConnectionState::DISCONNECTED ||
-             connection_state_ == ConnectionState::FAILED)) {
+void ConnectionManager::cancelReconnect() {
+    {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        reconnect_pending_ = false;
+        reconnect_attempts_ = 0;
+    }
+    reconnect_cv_.notify_one();
+}
 
-            setState(ConnectionState::RECONNECTING);
+void ConnectionManager::attemptReconnect() {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (!client_ || !conn_opts_ || client_->is_connected()) {
+        return;
+    }
 
-            if (connect(config_)) {
-                continue;
-            }
+    setState(ConnectionState::RECONNECTING);
+    try {
+        // тот же клиент и clean_session=false: брокер вернёт подписки,
+        // а Paho дошлёт неподтверждённые QoS1 сообщения
+        client_->connect(*conn_opts_, nullptr, *connect_listener_);
+    } catch (const mqtt::exception& e) {
+        handleError("Reconnect failed: " + std::string(e.what()));
+        setState(ConnectionState::FAILED);
+        scheduleReconnect();
+    }
+}
 
-            for (int i = 0; i < retry_interval_ && !should_stop_; ++i) {
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-            }
+void ConnectionManager::reconnectLoop() {
+    std::unique_lock<std::mutex> lock(reconnect_mutex_);
+    while (!should_stop_) {
+        // без запланированной попытки поток просто спит
+        reconnect_cv_.wait(lock,
+                           [this] { return should_stop_ || reconnect_pending_; });
+        if (should_stop_) {
+            break;
         }
+
+        const auto deadline = reconnect_at_;
+        const bool interrupted = reconnect_cv_.wait_until(
+            lock, deadline, [this, deadline] {
+                return should_stop_ || !reconnect_pending_ ||
+                       reconnect_at_ != deadline;
+            });
+        if (interrupted) {
+            continue;  // остановка, отмена или перенос попытки
+        }
+
+        reconnect_pending_ = false;
+        lock.unlock();
+        attemptReconnect();
+        lock.lock();
     }
 }
 
@@ -5,47 +5,98 @@
 
 namespace mqtt_connector {
 
-MessageHandler::MessageHandler() = default;
+namespace {
+
+constexpr std::string_view kSharePrefix = "$share/";
+
+std::vector<std::string_view> splitLevels(std::string_view topic) {
+    std::vector<std::string_view> levels;
+    std::size_t start = 0;
+    while (true) {
+        const auto slash = topic.find('/', start);
+        if (slash == std::string_view::npos) {
+            levels.push_back(topic.substr(start));
+            return levels;
+        }
+        levels.push_back(topic.substr(start, slash - start));
+        start = slash + 1;
+    }
+}
+
+/**
+ * @brief Фильтр без префикса shared subscription: брокер доставляет
+ * такие сообщения с обычным топиком
+ */
+std::string_view stripShare(std::string_view filter) {
+    if (filter.substr(0, kSharePrefix.size()) != kSharePrefix) {
+        return filter;
+    }
+    const auto slash = filter.find('/', kSharePrefix.size());
+    return slash == std::string_view::npos ? std::string_view()
+                                           : filter.substr(slash + 1);
+}
+
+}  // namespace
+
+MessageHandler::MessageHandler() : table_(std::make_shared<const Table>()) {}
 
 MessageHandler::~MessageHandler() = default;
 
 void MessageHandler::registerHandler(const std::string& topic, MessageCallback callback) {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    handlers_[topic] = std::move(callback);
+    auto table = std::make_shared<Table>();
+    const auto current = table_.load(std::memory_order_acquire);
+    table->filters = current->filters;
+    table->default_handler = current->default_handler;
+    table->filters[topic] = std::move(callback);
+    publish(std::move(table));
 }
 
 void MessageHandler::unregisterHandler(const std::string& topic) {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    handlers_.erase(topic);
+    const auto current = table_.load(std::memory_order_acquire);
+    if (current->filters.find(topic) == current->filters.end()) {
+        return;
+    }
+    auto table = std::make_shared<Table>();
+    table->filters = current->filters;
+    table->default_handler = current->default_handler;
+    table->filters.erase(topic);
+    publish(std::move(table));
 }
 
 void MessageHandler::handleMessage(const Message& message) {
-    std::lock_guard<std::mutex> lock(handlers_mutex_);
-    
-    bool handled = false;
-    
-    auto it = handlers_.find(message.topic);
-    if (it != handlers_.end()) {
-        it->second(message);
-        handled = true;
-    } 
-    
-    if (!handled && default_handler_) {
-        default_handler_(message);
+    // снимок держит колбэки живыми, пока они выполняются
+    const auto table = table_.load(std::memory_order_acquire);
+
+    std::vector<const MessageCallback*> matched;
+    if (!table->filters.empty()) {
+        collect(table->root, splitLevels(message.topic), 0, matched);
+    }
+
+    for (const auto* callback : matched) {
+        (*callback)(message);
+    }
+
+    if (matched.empty() && table->default_handler) {
+        table->default_handler(message);
     }
 }
 
 void MessageHandler::setDefaultHandler(MessageCallback callback) {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    default_handler_ = std::move(callback);
+    auto table = std::make_shared<Table>();
+    table->filters = table_.load(std::memory_order_acquire)->filters;
+    table->default_handler = std::move(callback);
+    publish(std::move(table));
 }
 
 std::vector<std::string> MessageHandler::getRegisteredTopics() const {
-    std::lock_guard<std::mutex> lock(handlers_mutex_);
+    const auto table = table_.load(std::memory_order_acquire);
     std::vector<std::string> topics;
-    topics.reserve(handlers_.size());
+    topics.reserve(table->filters.size());
     
-    for (const auto& [topic, _] : handlers_) {
+    for (const auto& [topic, _] : table->filters) {
         topics.push_back(topic);
     }
     
@@ -54,8 +105,81 @@ std::vector<std::string> MessageHandler::getRegisteredTopics() const {
 
 void MessageHandler::clearHandlers() {
     std::lock_guard<std::mutex> lock(handlers_mutex_);
-    handlers_.clear();
-    default_handler_ = nullptr;
+    table_.store(std::make_shared<const Table>(), std::memory_order_release);
+}
+
+bool MessageHandler::topicMatches(std::string_view filter, std::string_view topic) {
+    filter = stripShare(filter);
+    const auto f = splitLevels(filter);
+    const auto t = splitLevels(topic);
+
+    // служебные топики $SYS/... не попадают под wildcard первого уровня
+    if (!topic.empty() && topic.front() == '$' &&
+        (f.front() == "+" || f.front() == "#")) {
+        return false;
+    }
+
+    std::size_t i = 0;
+    for (; i < f.size(); ++i) {
+        if (f[i] == "#") {
+            return true;
+        }
+        if (i >= t.size()) {
+            return false;
+        }
+        if (f[i] != "+" && f[i] != t[i]) {
+            return false;
+        }
+    }
+    return i == t.size();
+}
+
+void MessageHandler::publish(std::shared_ptr<Table> table) {
+    for (const auto& [filter, callback] : table->filters) {
+        Node* node = &table->root;
+        for (const auto level : splitLevels(stripShare(filter))) {
+            auto& child = node->children[std::string(level)];
+            if (!child) {
+                child = std::make_unique<Node>();
+            }
+            node = child.get();
+        }
+        node->handlers.push_back(&callback);
+    }
+    table_.store(std::move(table), std::memory_order_release);
+}
+
+void MessageHandler::collect(const Node& node,
+                             const std::vector<std::string_view>& levels,
+                             std::size_t level,
+                             std::vector<const MessageCallback*>& out) {
+    // "a/#" подходит и к самому "a"
+    if (auto hash = node.children.find("#"); hash != node.children.end()) {
+        const bool system = level == 0 && !levels.front().empty() &&
+                            levels.front().front() == '$';
+        if (!system) {
+            out.insert(out.end(), hash->second->handlers.begin(),
+                       hash->second->handlers.end());
+        }
+    }
+
+    if (level == levels.size()) {
+        out.insert(out.end(), node.handlers.begin(), node.handlers.end());
+        return;
+    }
+
+    if (auto exact = node.children.find(levels[level]);
+        exact != node.children.end()) {
+        collect(*exact->second, levels, level + 1, out);
+    }
+
+    if (auto plus = node.children.find("+"); plus != node.children.end()) {
+        const bool system = level == 0 && !levels.front().empty() &&
+                            levels.front().front() == '$';
+        if (!system) {
+            collect(*plus->second, levels, level + 1, out);
+        }
+    }
 }
 
 } // namespace mqtt_connector
@@ -7,19 +7,91 @@
 #include <fstream>
 #include <sstream>
 
+#include <json.hpp>
+
+#include "logging/log.h"
+#include "tracing/trace.h"
+
+#include <QCoreApplication>
 #include <QPointF>
+#include <QSysInfo>
 
 namespace mqtt_connector {
 
+MqttClient::PipelineMetrics::PipelineMetrics(metrics::Registry& registry)
+    : messages_received(registry.counter("bacon_messages_received_total",
+                                         "MQTT messages received on all topics")),
+      adverts_parsed(registry.counter("bacon_adverts_parsed_total",
+                                      "Beacon adverts decoded")),
+      adverts_malformed(registry.counter("bacon_adverts_malformed_total",
+                                         "Beacon adverts with invalid JSON")),
+      adverts_dropped(registry.counter("bacon_adverts_dropped_total",
+                                       "Beacon adverts from unknown beacons")),
+      adverts_duplicate(registry.counter(
+          "bacon_adverts_duplicate_total",
+          "Advert copies dropped: repeated by a gateway or late for their tick")),
+      samples_fused(registry.counter("bacon_samples_fused_total",
+                                     "Gateway copies merged into one RSSI sample")),
+      samples_enqueued(registry.counter("bacon_samples_enqueued_total",
+                                        "RSSI samples put into ingest queues")),
+      samples_dequeued(registry.counter("bacon_samples_dequeued_total",
+                                        "RSSI samples taken by processing ticks")),
+      positions(registry.counter("bacon_positions_total", "Positions computed")),
+      solve_failures(registry.counter("bacon_solve_failures_total",
+                                      "Position computations that failed")),
+      samples_per_solve(registry.histogram("bacon_samples_per_solve",
+                                           "RSSI samples used by one position")),
+      solve_ns(registry.histogram("bacon_solve_duration_ns",
+                                  "Navigator time per position, ns")),
+      iterations(registry.histogram("bacon_trilateration_iterations",
+                                    "Gradient descent steps per position")),
+      advert_to_position_ns(registry.histogram(
+          "bacon_advert_to_position_ns",
+          "From the first advert of a tick to the emitted position, ns")),
+      zone_events(registry.counter("bacon_zone_events_total",
+                                   "Zone enter, exit and dwell events")),
+      zone_checks(registry.histogram("bacon_zone_checks",
+                                     "Polygons tested for one position near zones")) {}
+
 MqttClient::MqttClient()
-    : connection_manager_(std::make_unique<ConnectionManager>()),
+    : pipeline_metrics_(metrics_),
+      connection_manager_(std::make_unique<ConnectionManager>()),
       message_handler_(std::make_unique<MessageHandler>()),
-      initialized_(false) {
-    navigator_ = std::make_unique<navigator::Navigator>(m_beacons);
+      publisher_(std::make_unique<Publisher>(connection_manager_.get())),
+      position_publisher_(std::make_unique<PositionPublisher>(publisher_.get())),
+      initialized_(false),
+      beacon_names_(std::make_shared<const std::unordered_set<std::string>>()) {
+    ingest_shards_.push_back(std::make_unique<IngestShard>());
+    dedup_ = std::make_unique<AdvertDeduplicator>(ConnectionConfig().dedup_window_ms);
+    publisher_->setBackpressureCallback(
+        [this](bool engaged) { emit publishBackpressure(engaged); });
+
+    metrics_.gauge("bacon_ingest_queue_depth",
+                   "RSSI samples waiting for the next processing tick",
+                   [this] { return double(queuedSamples()); });
+    metrics_.gauge("bacon_publish_queue_depth",
+                   "Messages waiting to be handed to the MQTT client",
+                   [this] { return double(publisher_->queued()); });
+    metrics_.gauge("bacon_publish_in_flight",
+                   "Published messages not yet acknowledged by the broker",
+                   [this] { return double(publisher_->inFlight()); });
+    metrics_.gauge("bacon_tracked_tags", "Tags with a navigator, idle ones are evicted",
+                   [this] {
+                       std::lock_guard<std::mutex> nav_lock(navigators_mutex_);
+                       return double(navigators_.size());
+                   });
+    // только атомарное состояние: вызывается из потока экспорта
+    metrics_.gauge("bacon_connected", "1 if the main broker connection is up", [this] {
+        return connection_manager_->getConnectionState() == ConnectionState::CONNECTED
+                   ? 1.0
+                   : 0.0;
+    });
 }
 
 MqttClient::~MqttClient() {
+    stopMetricsExporter();
     shutdown();
+    stopRecording();
 }
 
 bool MqttClient::initialize(const ConnectionConfig& config) {
@@ -28,35 +100,60 @@ bool MqttClient::initialize(const ConnectionConfig& config) {
     }
 
     current_config_ = config;
+    const std::size_t shards =
+        static_cast<std::size_t>(std::max(1, config.ingest_shards));
+
+    // очереди пересоздаются, пока ни один поток Paho не запущен
+    clearBLEBeaconStates();  // учёт глубины очереди
+    ingest_shards_.clear();
+    for (std::size_t i = 0; i < shards; ++i) {
+        ingest_shards_.push_back(std::make_unique<IngestShard>());
+    }
+    dedup_ = config.dedup_window_ms > 0
+                 ? std::make_unique<AdvertDeduplicator>(config.dedup_window_ms)
+                 : nullptr;
 
-    connection_manager_->setConnectionCallback([this](ConnectionState state) {
-        if (state == ConnectionState::CONNECTED) {
-            restoreSubscriptions();
-        }
-    });
+    connection_manager_->setConnectionCallback(
+        [this](ConnectionState state) { onConnectionStateChanged(state); });
 
     connection_manager_->setMqttClient(this);
-
-    if (!connection_manager_->connect(config)) {
-        emit setConnectStatus("Disconnected");
-        return false;
+    connection_manager_->setShard(0);
+
+    for (std::size_t i = 1; i < shards; ++i) {
+        auto shard = std::make_unique<ConnectionManager>();
+        ConnectionManager* raw = shard.get();
+        shard->setMqttClient(this);
+        shard->setShard(i);
+        shard->setConnectionCallback([this, raw](ConnectionState state) {
+            onShardStateChanged(raw, state);
+        });
+        shard_connections_.push_back(std::move(shard));
     }
 
-    initialized_ = true;
+    // объявления разбираются как обычный обработчик топика
+    message_handler_->registerHandler(
+        advertTopic(), [this](const Message& message) { decodeAdvert(message); });
 
-    // subscribe("hakaton/board", 1, [this, &out](const Message& msg) {
-    //     std::cout << "Message received: " << msg.payload << std::endl;
-    // });
+    // Hardcode: подписка оформится, когда брокер подтвердит подключение
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        subscriptions_.push_back({advertTopic(), kAdvertQos});
+    }
 
-    // Hardcode:
-    connection_manager_->getClient()->subscribe("hakaton/board", 1);
+    initialized_ = true;
 
     should_stop_processing_ = false;
     processing_thread_ = std::thread(&MqttClient::dataProcessingLoop, this);
 
-    emit setConnectStatus("Connected");
+    // у каждого шарда своя сессия на брокере
+    for (std::size_t i = 0; i < shard_connections_.size(); ++i) {
+        ConnectionConfig shard_config = config;
+        shard_config.client_id += "-" + std::to_string(i + 1);
+        shard_connections_[i]->connect(shard_config);
+    }
 
-    return true;
+    // не ждём брокера: о результате сообщит onConnectionStateChanged
+    return connection_manager_->connect(config);
 }
 
 void MqttClient::shutdown() {
@@ -73,24 +170,14 @@ void MqttClient::shutdown() {
     }
 
     {
+        // серверную сессию брокер удалит сам по истечении срока
         std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-        for (const auto& topic : subscriptions_) {
-            try {
-                if (connection_manager_->isConnected()) {
-                    auto client = connection_manager_->getClient();
-                    if (client) {
-                        auto token = client->unsubscribe(topic);
-                        token->wait_for(std::chrono::seconds(5));
-                    }
-                }
-            } catch (const std::exception&) {
-                // Игнорируем ошибки при отключении
-            }
-        }
         subscriptions_.clear();
     }
 
+    publisher_->clear();
     connection_manager_->disconnect();
+    shard_connections_.clear();  // деструкторы отключают шарды
     message_handler_->clearHandlers();
 
     initialized_ = false;
@@ -98,97 +185,92 @@ void MqttClient::shutdown() {
 
 bool MqttClient::subscribe(const std::string& topic, int qos,
                            MessageCallback callback) {
-    if (!initialized_ || !connection_manager_->isConnected()) {
+    if (!initialized_) {
         return false;
     }
 
-    try {
-        auto client = connection_manager_->getClient();
-        if (!client) {
-            return false;
-        }
-
-        if (callback) {
-            message_handler_->registerHandler(topic, callback);
-        }
-
-        auto token = client->subscribe(topic, qos);
-        token->wait_for(std::chrono::seconds(10));
+    if (callback) {
+        message_handler_->registerHandler(topic, callback);
+    }
 
-        if (token->get_return_code() == mqtt::ReasonCode::SUCCESS) {
-            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-            if (std::find(subscriptions_.begin(), subscriptions_.end(),
-                          topic) == subscriptions_.end()) {
-                subscriptions_.push_back(topic);
-            }
-            return true;
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        auto it = std::find_if(
+            subscriptions_.begin(), subscriptions_.end(),
+            [&topic](const Subscription& s) { return s.topic == topic; });
+        if (it == subscriptions_.end()) {
+            subscriptions_.push_back({topic, qos});
+        } else {
+            it->qos = qos;
         }
+    }
 
-        return false;
+    // без подключения подписка оформится в restoreSubscriptions
+    if (!connection_manager_->isConnected()) {
+        return true;
+    }
 
+    try {
+        return connection_manager_->subscribe(topic, qos);
     } catch (const std::exception& e) {
-        connection_manager_->setErrorCallback([e](const std::string&) {
-            // Обработка ошибки подписки
-        });
+        connection_manager_->handleError("Subscribe failed: " +
+                                         std::string(e.what()));
         return false;
     }
 }
 
 bool MqttClient::unsubscribe(const std::string& topic) {
-    if (!initialized_ || !connection_manager_->isConnected()) {
+    if (!initialized_) {
         return false;
     }
 
-    try {
-        auto client = connection_manager_->getClient();
-        if (!client) {
-            return false;
-        }
-
-        auto token = client->unsubscribe(topic);
-        token->wait_for(std::chrono::seconds(10));
-
-        if (token->get_return_code() == mqtt::ReasonCode::SUCCESS) {
-            message_handler_->unregisterHandler(topic);
-
-            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-            subscriptions_.erase(std::remove(subscriptions_.begin(),
-                                             subscriptions_.end(), topic),
-                                 subscriptions_.end());
-
-            return true;
-        }
+    message_handler_->unregisterHandler(topic);
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        subscriptions_.erase(
+            std::remove_if(
+                subscriptions_.begin(), subscriptions_.end(),
+                [&topic](const Subscription& s) { return s.topic == topic; }),
+            subscriptions_.end());
+    }
 
-        return false;
+    if (!connection_manager_->isConnected()) {
+        return true;
+    }
 
+    try {
+        return connection_manager_->unsubscribe(topic);
     } catch (const std::exception&) {
         return false;
     }
 }
 
-bool MqttClient::publish(const Message& message) {
-    if (!initialized_ || !connection_manager_->isConnected()) {
+bool MqttClient::publish(const Message& message, PublishCallback callback) {
+    if (!initialized_) {
+        if (callback) {
+            callback(false);
+        }
         return false;
     }
+    // до подключения сообщения ждут в очереди
+    return publisher_->publish(message, std::move(callback));
+}
 
-    try {
-        auto client = connection_manager_->getClient();
-        if (!client) {
-            return false;
-        }
-
-        auto mqtt_msg = mqtt::make_message(message.topic, message.payload);
-        mqtt_msg->set_qos(message.qos);
-        mqtt_msg->set_retained(message.retained);
-
-        auto token = client->publish(mqtt_msg);
-        token->wait_for(std::chrono::seconds(10));
-
-        return token->get_return_code() == mqtt::ReasonCode::SUCCESS;
+std::future<bool> MqttClient::publishAsync(const Message& message) {
+    if (!initialized_) {
+        std::promise<bool> rejected;
+        rejected.set_value(false);
+        return rejected.get_future();
+    }
+    return publisher_->publishAsync(message);
+}
 
-    } catch (const std::exception&) {
+bool MqttClient::publishBatch(std::vector<Message> messages,
+                              PublishCallback callback) {
+    if (!initialized_) {
         return false;
     }
+    return publisher_->publishBatch(std::move(messages), std::move(callback));
 }
 
 bool MqttClient::publish(const std::string& topic, const std::string& payload,
@@ -225,13 +307,83 @@ void MqttClient::setErrorHandler(ErrorCallback callback) {
 
 std::vector<std::string> MqttClient::getActiveSubscriptions() const {
     std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-    return subscriptions_;
+    std::vector<std::string> topics;
+    topics.reserve(subscriptions_.size());
+    for (const auto& subscription : subscriptions_) {
+        topics.push_back(subscription.topic);
+    }
+    return topics;
 }
 
 void MqttClient::setAutoReconnect(bool enable, int retry_interval) {
     if (connection_manager_) {
         connection_manager_->setAutoReconnect(enable, retry_interval);
     }
+    for (auto& shard : shard_connections_) {
+        shard->setAutoReconnect(enable, retry_interval);
+    }
+}
+
+void MqttClient::startRecording(const recorder::RecorderOptions& options) {
+    stopRecording();
+    recorder_.store(
+        std::make_shared<recorder::Recorder>(options, ingest_shards_.size()),
+        std::memory_order_release);
+}
+
+void MqttClient::stopRecording() {
+    auto recorder = recorder_.exchange(nullptr, std::memory_order_acq_rel);
+    if (recorder) {
+        // поток Paho мог взять указатель раньше: stop() лишь дописывает
+        // файл, сам объект живёт, пока жива последняя ссылка
+        recorder->stop();
+    }
+}
+
+bool MqttClient::startMetricsExporter(const metrics::ExporterOptions& options) {
+    stopMetricsExporter();
+    auto exporter = std::make_unique<metrics::Exporter>(metrics_, options);
+    if (!exporter->start()) {
+        return false;
+    }
+    BACON_LOG_INFO("metrics", "exporter started", "address", options.bind_address,
+                   "port", exporter->port());
+    exporter->addHandler("/trace", "application/json",
+                         [] { return tracing::chromeTrace(); });
+    metrics_exporter_ = std::move(exporter);
+    return true;
+}
+
+std::size_t MqttClient::queuedSamples() const {
+    // счётчики читаются не атомарно вместе, отрицательную разность обрезаем
+    const auto dequeued = pipeline_metrics_.samples_dequeued.value();
+    const auto enqueued = pipeline_metrics_.samples_enqueued.value();
+    return enqueued > dequeued ? static_cast<std::size_t>(enqueued - dequeued) : 0;
+}
+
+void MqttClient::stopMetricsExporter() {
+    metrics_exporter_.reset();
+}
+
+void MqttClient::setNavigatorConfig(const navigator::NavigatorConfig& config) {
+    std::lock_guard<std::mutex> nav_lock(navigators_mutex_);
+    navigator_config_ = config;
+    navigators_.clear();
+}
+
+void MqttClient::setPositionStream(const PositionStreamOptions& options) {
+    position_publisher_->setOptions(options);
+}
+
+void MqttClient::setZones(std::vector<zones::Zone> zones,
+                          const zones::ZoneOptions& options) {
+    // индекс строится здесь, такт лишь подхватывает готовый
+    zone_engine_.setZones(std::move(zones), options);
+}
+
+void MqttClient::setZoneStream(const ZoneStreamOptions& options) {
+    std::lock_guard<std::mutex> lock(zone_stream_mutex_);
+    zone_stream_ = options;
 }
 
 std::string MqttClient::getStatus() const {
@@ -264,12 +416,23 @@ std::string MqttClient::getStatus() const {
     status << "  Broker: " << current_config_.broker_host << ":"
            << current_config_.broker_port << "\n";
     status << "  Client ID: " << current_config_.client_id << "\n";
+    status << "  Ingest shards: " << shard_connections_.size() + 1 << "\n";
+    if (auto recorder = recorder_.load(std::memory_order_acquire)) {
+        status << "  Recording: " << recorder->currentFile() << " ("
+               << recorder->recorded() << " written, " << recorder->dropped()
+               << " dropped)\n";
+    }
+    status << "  Positions published: " << position_publisher_->published()
+           << ", suppressed: " << position_publisher_->suppressed()
+           << ", rejected tags: " << position_publisher_->rejected() << "\n";
+    status << "  Metrics:\n" << metrics_.format("    ");
 
     {
         std::lock_guard<std::mutex> lock(subscriptions_mutex_);
         status << "  Active subscriptions: " << subscriptions_.size() << "\n";
-        for (const auto& topic : subscriptions_) {
-            status << "    - " << topic << "\n";
+        for (const auto& subscription : subscriptions_) {
+            status << "    - " << subscription.topic << " (qos "
+                   << subscription.qos << ")\n";
         }
     }
 
@@ -286,22 +449,66 @@ std::string MqttClient::getStatus() const {
 void MqttClient::setBLEBeaconState(
     const std::string& key,
     const std::vector<message_objects::BLEBeaconState>& states) {
-    std::lock_guard<std::mutex> lock(m_data_mutex_);
-    m_data[key] = states;
+    const std::string tag =
+        states.empty() ? message_objects::kDefaultTag : states.front().tag_;
+    auto& shard = *ingest_shards_.front();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& samples = shard.data[tag];
+    if (samples.beacons.empty()) {
+        samples.first_arrival = std::chrono::steady_clock::now();
+    }
+    auto& target = samples.beacons[key];
+    // заменённые измерения считаем забранными, чтобы глубина очереди сходилась
+    pipeline_metrics_.samples_dequeued.add(target.size());
+    pipeline_metrics_.samples_enqueued.add(states.size());
+    target = states;
 }
 
 void MqttClient::addBLEBeaconState(
     const std::string& key, const message_objects::BLEBeaconState& state) {
-    std::lock_guard<std::mutex> lock(m_data_mutex_);
-    m_data[key].push_back(state);
+    addBLEBeaconState(0, key, state);
 }
 
-bool MqttClient::BLEBeaconContains(const std::string& name) {
-    std::lock_guard<std::mutex> lock(m_beacons_mutex_);
-    return std::any_of(m_beacons.begin(), m_beacons.end(),
-                       [&name](const message_objects::BLEBeacon& beacon) {
-                           return beacon.name_ == name;
-                       });
+void MqttClient::addBLEBeaconState(
+    std::size_t shard, const std::string& key,
+    const message_objects::BLEBeaconState& state, std::int64_t capture_ms) {
+    tracing::Span span(tracing::Stage::ENQUEUE);
+    // при воспроизведении окно отсева идёт по времени записи, а не по часам
+    if (dedup_ &&
+        dedup_->check(state, tick_generation_.load(std::memory_order_relaxed),
+                      capture_ms > 0 ? static_cast<std::uint32_t>(capture_ms)
+                                     : dedup_->clockMs()) !=
+            AdvertDeduplicator::Verdict::ACCEPT) {
+        pipeline_metrics_.adverts_duplicate.add();
+        return;
+    }
+    auto& ingest = *ingest_shards_[shard % ingest_shards_.size()];
+    {
+        std::lock_guard<std::mutex> lock(ingest.mutex);
+        auto& samples = ingest.data[state.tag_];
+        if (samples.beacons.empty()) {
+            samples.first_arrival = std::chrono::steady_clock::now();
+        }
+        samples.beacons[key].push_back(state);
+    }
+    pipeline_metrics_.samples_enqueued.add();
+}
+
+void MqttClient::clearBLEBeaconStates() {
+    for (auto& shard : ingest_shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& [tag, samples] : shard->data) {
+            for (const auto& [beacon, states] : samples.beacons) {
+                pipeline_metrics_.samples_dequeued.add(states.size());
+            }
+        }
+        shard->data.clear();
+    }
+}
+
+bool MqttClient::BLEBeaconContains(const std::string& name) const {
+    const auto names = beacon_names_.load(std::memory_order_acquire);
+    return names->count(name) != 0;
 }
 
 void MqttClient::initOnChange(const QString& url) {
@@ -316,11 +523,19 @@ void MqttClient::initOnChange(const QString& url) {
         config.broker_port = 1883;  // стандартный порт MQTT
     }
 
-    config.client_id = "client_id";
+    // id должен быть уникальным: брокер держит по нему сессию,
+    // а одинаковые id выбивают друг друга
+    config.client_id = QString("bacon-%1-%2")
+                           .arg(QSysInfo::machineHostName())
+                           .arg(QCoreApplication::applicationPid())
+                           .toStdString();
     config.keep_alive_interval = 60;
-    config.clean_session = true;
+    config.clean_session = false;  // подписки и QoS1 переживают обрыв
     config.connection_timeout = 30;
     config.use_ssl = false;
+    // параллельный приём через shared subscription, как ingest.shards у bacond
+    config.ingest_shards =
+        std::max(1, qEnvironmentVariableIntValue("BACON_INGEST_SHARDS"));
 
     initialize(config);
 }
@@ -331,83 +546,346 @@ void MqttClient::setFreqOnChange(float freq) {
 }
 
 void MqttClient::setBeacons(const QList<QPair<QString, QPointF>>& newBeacons) {
-    std::lock_guard<std::mutex> lock(m_beacons_mutex_);
-    m_beacons.clear();
+    std::vector<message_objects::BLEBeacon> beacons;
+    auto names = std::make_shared<std::unordered_set<std::string>>();
     for (const auto& pair : newBeacons) {
-        std::cout << pair.first.toStdString() << std::endl;
         message_objects::BLEBeacon beacon;
         beacon.name_ = pair.first.toStdString();
         beacon.x_ = pair.second.x();
         beacon.y_ = pair.second.y();
-        m_beacons.push_back(beacon);
+        beacons.push_back(beacon);
+        names->insert(beacon.name_);
     }
-    navigator_->setKnownBeacons(m_beacons);
+    {
+        std::lock_guard<std::mutex> lock(m_beacons_mutex_);
+        m_beacons = beacons;
+    }
+    BACON_LOG_DEBUG("mqtt", "beacons updated", "count", names->size());
+    beacon_names_.store(std::move(names), std::memory_order_release);
+    // навигаторы в этот момент может считать поток такта, поэтому маяки
+    // им передаёт он сам на следующем такте. navigators_mutex_ берётся
+    // раньше m_beacons_mutex_, оба сразу здесь не держим
+    std::lock_guard<std::mutex> nav_lock(navigators_mutex_);
+    ++beacons_version_;
 }
 
 void MqttClient::onMessageReceived(const Message& message) {
+    tracing::Span span(tracing::Stage::RECEIVE);
+    pipeline_metrics_.messages_received.add();
     message_handler_->handleMessage(message);
 }
 
+void MqttClient::decodeAdvert(const Message& message) {
+    try {
+        nlohmann::json json_data = nlohmann::json::parse(message.payload);
+
+        message_objects::BLEBeaconState state;
+        state.name_ = json_data["name"];
+        state.txPower_ = json_data["tx_power"];
+        state.rssi_ = json_data["rssi"];
+        state.tag_ =
+            json_data.value("tag", std::string(message_objects::kDefaultTag));
+        state.gateway_ = json_data.value("gateway", std::string());
+        state.seq_ = json_data.value("seq", std::uint32_t{0});
+        if (state.seq_ == 0 && json_data.contains("ts")) {
+            // без номера объявление опознаётся по отметке времени метки
+            const auto ts = json_data["ts"].get<std::uint64_t>();
+            state.seq_ = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(ts ^ (ts >> 32)));
+        }
+
+        // пишем всё подряд: при разборе журнала набор маяков может быть другим
+        if (auto recorder = recorder_.load(std::memory_order_acquire)) {
+            recorder->record(message.shard, message.topic, state);
+        }
+
+        pipeline_metrics_.adverts_parsed.add();
+        if (!BLEBeaconContains(state.name_)) {
+            pipeline_metrics_.adverts_dropped.add();
+            return;
+        }
+
+        // каждый клиент Paho пишет в свой шард, без общей блокировки
+        addBLEBeaconState(message.shard, state.name_, state, message.timestamp_ms);
+    } catch (const nlohmann::json::exception& e) {
+        pipeline_metrics_.adverts_malformed.add();
+        BACON_LOG_WARN("mqtt", "malformed advert", "topic", message.topic,
+                       "error", e.what());
+    }
+}
+
 void MqttClient::restoreSubscriptions() {
     std::lock_guard<std::mutex> lock(subscriptions_mutex_);
 
-    for (const auto& topic : subscriptions_) {
+    for (const auto& subscription : subscriptions_) {
         try {
-            auto client = connection_manager_->getClient();
-            if (client) {
-                client->subscribe(topic, 0);
-            }
+            // без ожидания: вызывается из потока Paho
+            connection_manager_->subscribe(subscription.topic, subscription.qos);
         } catch (const std::exception&) {
             // Игнорируем ошибки восстановления подписок
         }
     }
 }
 
+void MqttClient::onConnectionStateChanged(ConnectionState state) {
+    publisher_->onConnectionStateChanged(state);
+
+    switch (state) {
+        case ConnectionState::CONNECTED:
+            // при сохранённой сессии подписки уже есть на брокере
+            if (!connection_manager_->isSessionPresent()) {
+                restoreSubscriptions();
+            }
+            emit setConnectStatus("Connected");
+            break;
+        case ConnectionState::CONNECTING:
+            emit setConnectStatus("Connecting");
+            break;
+        case ConnectionState::RECONNECTING:
+            emit setConnectStatus("Reconnecting");
+            break;
+        case ConnectionState::FAILED:
+            emit setConnectStatus("Failed");
+            break;
+        case ConnectionState::DISCONNECTED:
+            emit setConnectStatus("Disconnected");
+            break;
+    }
+}
+
+void MqttClient::onShardStateChanged(ConnectionManager* shard,
+                                     ConnectionState state) {
+    if (state != ConnectionState::CONNECTED || shard->isSessionPresent()) {
+        return;
+    }
+    try {
+        shard->subscribe(advertTopic(), kAdvertQos);
+    } catch (const std::exception&) {
+        // повторим при следующем подключении
+    }
+}
+
+std::string MqttClient::advertTopic() const {
+    if (current_config_.ingest_shards <= 1) {
+        return kAdvertTopic;
+    }
+    return "$share/" + current_config_.shared_group + "/" + kAdvertTopic;
+}
+
 void MqttClient::dataProcessingLoop() {
     while (!should_stop_processing_) {
-        std::unique_lock<std::mutex> lock(processing_mutex_);
-        float current_freq;
         {
-            std::lock_guard<std::mutex> freq_lock(m_freq_mutex_);
-            current_freq = m_freq;
-        }
+            std::unique_lock<std::mutex> lock(processing_mutex_);
+            float current_freq;
+            {
+                std::lock_guard<std::mutex> freq_lock(m_freq_mutex_);
+                current_freq = m_freq;
+            }
 
-        auto wait_duration =
-            std::chrono::milliseconds(static_cast<int>(1000.0f / current_freq));
+            auto wait_duration = std::chrono::milliseconds(
+                static_cast<int>(1000.0f / current_freq));
 
-        if (processing_cv_.wait_for(lock, wait_duration) ==
-            std::cv_status::no_timeout) {
-            if (should_stop_processing_) {
-                break;
+            if (processing_cv_.wait_for(lock, wait_duration) ==
+                std::cv_status::no_timeout) {
+                if (should_stop_processing_) {
+                    break;
+                }
             }
         }
 
-        std::vector<std::pair<std::string,
-                              std::vector<message_objects::BLEBeaconState>>>
-            collected_data;
+        processTick(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count());
+    }
+}
+
+std::size_t MqttClient::processTick(std::int64_t now_ms) {
+    tracing::Span tick_span(tracing::Stage::TICK);
+    // копии, пришедшие после этой точки, к уже забранным объявлениям опоздали
+    tick_generation_.fetch_add(1, std::memory_order_relaxed);
+    // забираем очереди шардов по одной, держа только её мьютекс
+    std::map<std::string, TagSamples> collected_data;
+    for (auto& shard : ingest_shards_) {
+        std::map<std::string, TagSamples> shard_data;
         {
-            std::lock_guard<std::mutex> data_lock(m_data_mutex_);
-            if (!m_data.empty()) {
-                std::cout << m_data.size() << std::endl;
-                for (const auto& pair : m_data) {
-                    collected_data.emplace_back(pair.first, pair.second);
+            std::lock_guard<std::mutex> data_lock(shard->mutex);
+            shard_data.swap(shard->data);
+        }
+        if (collected_data.empty()) {
+            collected_data.swap(shard_data);
+            continue;
+        }
+        for (auto& [tag, samples] : shard_data) {
+            auto [it, inserted] = collected_data.try_emplace(tag);
+            auto& merged = it->second;
+            if (inserted || samples.first_arrival < merged.first_arrival) {
+                merged.first_arrival = samples.first_arrival;
+            }
+            for (auto& [beacon, states] : samples.beacons) {
+                auto& target = merged.beacons[beacon];
+                target.insert(target.end(),
+                              std::make_move_iterator(states.begin()),
+                              std::make_move_iterator(states.end()));
+            }
+        }
+    }
+
+    // под navigators_mutex_ только поиск и создание навигаторов, расчёт,
+    // сигналы и публикация - без него
+    std::vector<std::shared_ptr<navigator::Navigator>> tick_navigators;
+    tick_navigators.reserve(collected_data.size());
+    bool sweep = false;
+    {
+        std::lock_guard<std::mutex> nav_lock(navigators_mutex_);
+        for (const auto& [tag, samples] : collected_data) {
+            auto& entry = navigators_[tag];
+            if (!entry.navigator || entry.beacons_version != beacons_version_) {
+                std::lock_guard<std::mutex> beacons_lock(m_beacons_mutex_);
+                if (!entry.navigator) {
+                    entry.navigator = std::make_shared<navigator::Navigator>(
+                        m_beacons, navigator_config_);
+                } else {
+                    entry.navigator->setKnownBeacons(m_beacons);
                 }
-                m_data.clear();
+                entry.beacons_version = beacons_version_;
             }
+            entry.seen_ms = now_ms;
+            tick_navigators.push_back(entry.navigator);
+        }
+        if (now_ms - idle_swept_ms_ >= kIdleSweepMs) {
+            idle_swept_ms_ = now_ms;
+            sweep = true;
+            std::erase_if(navigators_, [now_ms](const auto& item) {
+                return now_ms - item.second.seen_ms > kTagIdleMs;
+            });
         }
+    }
 
-        if (navigator_ && !collected_data.empty()) {
-            try {
-                auto position = navigator_->calculatePosition(collected_data);
-                QPointF pos(position.first, position.second);
+    std::size_t positions = 0;
+    auto navigator_it = tick_navigators.begin();
+    for (auto& [tag, samples] : collected_data) {
+        const auto& navigator = *navigator_it++;
+
+        std::vector<std::pair<
+            std::string, std::vector<message_objects::BLEBeaconState>>>
+            measurements(std::make_move_iterator(samples.beacons.begin()),
+                         std::make_move_iterator(samples.beacons.end()));
+        std::size_t sample_count = 0;
+        std::size_t fused = 0;
+        for (auto& [beacon, states] : measurements) {
+            sample_count += states.size();
+            fused += fuseGatewayCopies(states);
+        }
+        pipeline_metrics_.samples_dequeued.add(sample_count);
+        pipeline_metrics_.samples_fused.add(fused);
 
-                emit addPathPoint(pos);
-            } catch (const std::exception& e) {
-                std::cerr << "Error calculating position: " << e.what()
-                          << std::endl;
+        const std::uint64_t trace_id = tracing::enabled() ? tracing::nextId() : 0;
+        try {
+            const auto solve_start = std::chrono::steady_clock::now();
+            std::pair<double, double> position;
+            {
+                tracing::Span span(tracing::Stage::SOLVE, trace_id, tag);
+                position = navigator->calculatePosition(measurements);
+            }
+            const auto solve_end = std::chrono::steady_clock::now();
+            pipeline_metrics_.solve_ns.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    solve_end - solve_start)
+                    .count());
+            pipeline_metrics_.samples_per_solve.record(
+                navigator->lastSolve().samples);
+            pipeline_metrics_.iterations.record(
+                navigator->lastSolve().iterations);
+
+            QPointF pos(position.first, position.second);
+
+            {
+                // прямые получатели сигнала забирают id через currentId()
+                tracing::Span span(tracing::Stage::EMIT, trace_id, tag);
+                tracing::setCurrentId(trace_id);
+                emit addPathPoint(QString::fromStdString(tag), pos);
+                tracing::setCurrentId(0);
+
+                position_publisher_->offer(tag, position.first, position.second,
+                                           now_ms);
+            }
+            pipeline_metrics_.advert_to_position_ns.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - samples.first_arrival)
+                    .count());
+            pipeline_metrics_.positions.add();
+            ++positions;
+
+            if (zone_engine_.update(tag, position.first, position.second, now_ms,
+                                    zone_events_) > 0) {
+                publishZoneEvents();
+            }
+            if (zone_engine_.lastTested() > 0) {
+                pipeline_metrics_.zone_checks.record(zone_engine_.lastTested());
+            }
+        } catch (const std::exception& e) {
+            pipeline_metrics_.solve_failures.add();
+            BACON_LOG_WARN("navigator", "position failed", "tag", tag,
+                           "error", e.what());
+        }
+    }
+
+    if (sweep) {
+        position_publisher_->evictIdle(now_ms, kTagIdleMs);
+        const std::size_t evicted = zone_engine_.evictIdle(now_ms, kTagIdleMs, zone_events_);
+        if (!zone_events_.empty()) {
+            publishZoneEvents();
+        }
+        if (evicted > 0) {
+            BACON_LOG_DEBUG("zones", "idle tags evicted", "count", evicted);
+        }
+    }
+    return positions;
+}
+
+void MqttClient::publishZoneEvents() {
+    ZoneStreamOptions stream;
+    {
+        std::lock_guard<std::mutex> lock(zone_stream_mutex_);
+        stream = zone_stream_;
+    }
+    for (const auto& event : zone_events_) {
+        pipeline_metrics_.zone_events.add();
+        emit zoneEvent(QString::fromStdString(event.tag), QString::fromStdString(event.zone),
+                       QString::fromLatin1(zones::eventName(event.type)),
+                       QPointF(event.x, event.y));
+        if (stream.enabled) {
+            Message message(stream.topic_prefix + "/" + event.zone, zones::encodeJson(event),
+                            stream.qos);
+            if (!publisher_->publish(std::move(message))) {
+                BACON_LOG_WARN("zones", "zone event not published", "tag", event.tag,
+                               "zone", event.zone, "event", zones::eventName(event.type));
             }
         }
     }
+    zone_events_.clear();
+}
+
+void MqttClient::initializeReplay(std::size_t shards) {
+    if (initialized_) {
+        shutdown();
+    }
+
+    current_config_ = ConnectionConfig();
+    clearBLEBeaconStates();
+    ingest_shards_.clear();
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, shards); ++i) {
+        ingest_shards_.push_back(std::make_unique<IngestShard>());
+    }
+    dedup_ = std::make_unique<AdvertDeduplicator>(current_config_.dedup_window_ms);
+    {
+        // навигаторы с чистым сглаживанием: прогоны сравнимы между собой
+        std::lock_guard<std::mutex> nav_lock(navigators_mutex_);
+        navigators_.clear();
+    }
+    idle_swept_ms_ = 0;
+
+    message_handler_->registerHandler(
+        advertTopic(), [this](const Message& message) { decodeAdvert(message); });
 }
 
 }  // namespace mqtt_connector
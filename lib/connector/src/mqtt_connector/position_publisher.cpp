@@ -0,0 +1,150 @@
+#include "mqtt_connector/position_publisher.h"
+#include "mqtt_connector/publisher.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include <json.hpp>
+
+namespace mqtt_connector {
+
+namespace {
+
+constexpr std::uint8_t kBinaryVersion = 1;
+
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big) {
+        std::reverse(std::begin(bytes), std::end(bytes));
+    }
+    out.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+}  // namespace
+
+PositionPublisher::PositionPublisher(Publisher* publisher)
+    : publisher_(publisher) {}
+
+void PositionPublisher::setOptions(const PositionStreamOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    last_sent_.clear();
+}
+
+PositionStreamOptions PositionPublisher::options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+bool PositionPublisher::offer(const std::string& tag, double x, double y,
+                              std::int64_t timestamp_ms) {
+    Message message;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!options_.enabled) {
+            return false;
+        }
+        // '/' увёл бы позицию в чужой топик, с '+' и '#' публикация не проходит
+        if (!isValidTopicLevel(tag)) {
+            ++rejected_;
+            return false;
+        }
+
+        auto it = last_sent_.find(tag);
+        if (it != last_sent_.end()) {
+            const LastSent& last = it->second;
+            if (options_.max_rate_hz > 0 &&
+                timestamp_ms - last.timestamp_ms <
+                    static_cast<std::int64_t>(1000.0 / options_.max_rate_hz)) {
+                ++suppressed_;
+                return false;
+            }
+            if (std::hypot(x - last.x, y - last.y) < options_.min_delta) {
+                ++suppressed_;
+                return false;
+            }
+        }
+
+        message.topic = options_.topic_prefix + "/" + tag;
+        message.payload = options_.encoding == PositionEncoding::BINARY
+                              ? encodeBinary(tag, x, y, timestamp_ms)
+                              : encodeJson(tag, x, y, timestamp_ms);
+        message.qos = options_.qos;
+    }
+
+    if (!publisher_->publish(std::move(message))) {
+        return false;  // backpressure: следующая позиция будет свежее
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_sent_[tag] = {x, y, timestamp_ms};
+    ++published_;
+    return true;
+}
+
+void PositionPublisher::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_sent_.clear();
+}
+
+std::size_t PositionPublisher::evictIdle(std::int64_t now_ms, std::int64_t idle_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::erase_if(last_sent_, [now_ms, idle_ms](const auto& item) {
+        return now_ms - item.second.timestamp_ms > idle_ms;
+    });
+}
+
+std::uint64_t PositionPublisher::published() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return published_;
+}
+
+std::uint64_t PositionPublisher::suppressed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return suppressed_;
+}
+
+std::uint64_t PositionPublisher::rejected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+}
+
+bool PositionPublisher::isValidTopicLevel(const std::string& tag) {
+    return !tag.empty() && tag.find_first_of(std::string_view("/+#\0", 4)) == std::string::npos;
+}
+
+std::string PositionPublisher::encodeJson(const std::string& tag, double x,
+                                          double y, std::int64_t timestamp_ms) {
+    nlohmann::json json_data;
+    json_data["tag"] = tag;
+    json_data["x"] = x;
+    json_data["y"] = y;
+    json_data["ts"] = timestamp_ms;
+    return json_data.dump();
+}
+
+std::string PositionPublisher::encodeBinary(const std::string& tag, double x,
+                                            double y,
+                                            std::int64_t timestamp_ms) {
+    const std::size_t tag_size = std::min<std::size_t>(tag.size(), 255);
+
+    std::string out;
+    out.reserve(4 + tag_size + sizeof(std::int64_t) + 2 * sizeof(float));
+    out.push_back('B');
+    out.push_back('P');
+    out.push_back(static_cast<char>(kBinaryVersion));
+    out.push_back(static_cast<char>(tag_size));
+    out.append(tag, 0, tag_size);
+    appendLittleEndian(out, timestamp_ms);
+    appendLittleEndian(out, static_cast<float>(x));
+    appendLittleEndian(out, static_cast<float>(y));
+    return out;
+}
+
+} // namespace mqtt_connector
@@ -0,0 +1,254 @@
+#include "mqtt_connector/publisher.h"
+#include "mqtt_connector/connection_manager.h"
+
+#include <mqtt/async_client.h>
+
+#include <stdexcept>
+
+namespace mqtt_connector {
+
+/**
+ * @brief Один слушатель на все публикации: конкретное сообщение
+ * находится по user context токена
+ */
+class Publisher::DeliveryListener : public virtual mqtt::iaction_listener {
+   public:
+    explicit DeliveryListener(Publisher* publisher) : publisher_(publisher) {}
+
+    void on_success(const mqtt::token& tok) override {
+        publisher_->complete(
+            reinterpret_cast<PendingId>(tok.get_user_context()), true);
+    }
+
+    void on_failure(const mqtt::token& tok) override {
+        publisher_->complete(
+            reinterpret_cast<PendingId>(tok.get_user_context()), false);
+    }
+
+   private:
+    Publisher* publisher_;
+};
+
+Publisher::Publisher(ConnectionManager* connection, PublisherOptions options)
+    : connection_(connection),
+      options_(options),
+      listener_(std::make_unique<DeliveryListener>(this)),
+      connected_(connection->isConnected()) {
+    sender_thread_ = std::thread(&Publisher::senderLoop, this);
+}
+
+Publisher::~Publisher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        should_stop_ = true;
+    }
+    cv_.notify_all();
+    if (sender_thread_.joinable()) {
+        sender_thread_.join();
+    }
+    clear();
+}
+
+bool Publisher::publish(Message message, PublishCallback callback) {
+    std::optional<bool> changed;
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() < options_.max_queued) {
+            queue_.push_back({std::move(message), std::move(callback)});
+            accepted = true;
+            cv_.notify_one();
+        }
+        changed = updateBackpressureLocked();
+    }
+    notifyBackpressure(changed);
+    if (!accepted && callback) {
+        callback(false);
+    }
+    return accepted;
+}
+
+std::future<bool> Publisher::publishAsync(Message message) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+    publish(std::move(message),
+            [promise](bool delivered) { promise->set_value(delivered); });
+    return future;
+}
+
+bool Publisher::publishBatch(std::vector<Message> messages,
+                             PublishCallback callback) {
+    std::optional<bool> changed;
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() + messages.size() <= options_.max_queued) {
+            for (auto& message : messages) {
+                queue_.push_back({std::move(message), callback});
+            }
+            accepted = true;
+            cv_.notify_one();
+        }
+        changed = updateBackpressureLocked();
+    }
+    notifyBackpressure(changed);
+    if (!accepted && callback) {
+        for (std::size_t i = 0; i < messages.size(); ++i) {
+            callback(false);
+        }
+    }
+    return accepted;
+}
+
+void Publisher::setBackpressureCallback(BackpressureCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backpressure_callback_ = std::move(callback);
+}
+
+std::size_t Publisher::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+std::size_t Publisher::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_.size();
+}
+
+void Publisher::onConnectionStateChanged(ConnectionState state) {
+    std::unordered_map<PendingId, Pending> abandoned;
+    {
+        // состояние меняется под mutex_: поток отправки не пропустит
+        // уведомление между проверкой условия и засыпанием
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = state == ConnectionState::CONNECTED;
+        if (state == ConnectionState::CONNECTING) {
+            // старый клиент удалён вместе со своими токенами
+            abandoned.swap(in_flight_);
+        }
+    }
+    cv_.notify_one();
+    for (auto& [id, pending] : abandoned) {
+        if (pending.callback) {
+            pending.callback(false);
+        }
+    }
+}
+
+void Publisher::clear() {
+    std::deque<Pending> queued;
+    std::unordered_map<PendingId, Pending> in_flight;
+    std::optional<bool> changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued.swap(queue_);
+        in_flight.swap(in_flight_);
+        changed = updateBackpressureLocked();
+    }
+    notifyBackpressure(changed);
+    for (auto& pending : queued) {
+        if (pending.callback) {
+            pending.callback(false);
+        }
+    }
+    for (auto& [id, pending] : in_flight) {
+        if (pending.callback) {
+            pending.callback(false);
+        }
+    }
+}
+
+void Publisher::senderLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] {
+            return should_stop_ ||
+                   (!queue_.empty() &&
+                    in_flight_.size() < options_.max_in_flight && connected_);
+        });
+        if (should_stop_) {
+            break;
+        }
+
+        // всё, что помещается в свободное окно, уходит подряд, без ожидания
+        // подтверждения каждого; сообщения не склеиваются - у MQTT нет
+        // кадра на несколько публикаций
+        std::vector<std::pair<PendingId, mqtt::message_ptr>> batch;
+        while (!queue_.empty() && in_flight_.size() < options_.max_in_flight) {
+            Pending pending = std::move(queue_.front());
+            queue_.pop_front();
+
+            auto msg = mqtt::make_message(pending.message.topic,
+                                          pending.message.payload);
+            msg->set_qos(pending.message.qos);
+            msg->set_retained(pending.message.retained);
+
+            const PendingId id = next_id_++;
+            in_flight_.emplace(id, std::move(pending));
+            batch.emplace_back(id, std::move(msg));
+        }
+        const auto changed = updateBackpressureLocked();
+        lock.unlock();
+
+        notifyBackpressure(changed);
+        for (auto& [id, msg] : batch) {
+            try {
+                // клиент берётся под блокировкой менеджера: смена адреса или
+                // отключение не удалят его посреди публикации
+                if (!connection_->publish(msg, reinterpret_cast<void*>(id), *listener_)) {
+                    throw std::runtime_error("no client");
+                }
+            } catch (const std::exception&) {
+                complete(id, false);
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+void Publisher::complete(PendingId id, bool delivered) {
+    PublishCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = in_flight_.find(id);
+        if (it == in_flight_.end()) {
+            return;  // уже отменено
+        }
+        callback = std::move(it->second.callback);
+        in_flight_.erase(it);
+    }
+    cv_.notify_one();
+    if (callback) {
+        callback(delivered);
+    }
+}
+
+std::optional<bool> Publisher::updateBackpressureLocked() {
+    const bool engaged = backpressured_;
+    if (!engaged && queue_.size() >= options_.max_queued) {
+        backpressured_ = true;
+        return true;
+    }
+    if (engaged && queue_.size() <= options_.low_watermark) {
+        backpressured_ = false;
+        return false;
+    }
+    return std::nullopt;
+}
+
+void Publisher::notifyBackpressure(std::optional<bool> changed) {
+    if (!changed) {
+        return;
+    }
+    BackpressureCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = backpressure_callback_;
+    }
+    if (callback) {
+        callback(*changed);
+    }
+}
+
+} // namespace mqtt_connector
@@ -1,4 +1,5 @@
 #include "navigator/navigator.h"
+#include "navigator/solver.h"
 #include <Eigen/Dense>
 #include <algorithm>
 #include <cmath>
@@ -16,17 +17,16 @@ void Navigator::setKnownBeacons(
 }
 
 // --- конструктор ---
-Navigator::Navigator(const std::vector<BLEBeacon>& knownBeacons, double alpha,
-                     double positionAlpha)
-    : knownBeacons_(knownBeacons),
-      alpha_(alpha),
-      positionAlpha_(positionAlpha) {}
+Navigator::Navigator(const std::vector<BLEBeacon>& knownBeacons,
+                     NavigatorConfig config)
+    : knownBeacons_(knownBeacons), config_(config) {}
 
 // --- calculatePosition ---
 std::pair<double, double> Navigator::calculatePosition(
     std::vector<std::pair<std::string, std::vector<BLEBeaconState>>>&
         beaconMeasurements) {
     std::vector<std::pair<BLEBeacon, double>> distances;
+    lastSolve_ = SolveStats();
 
     for (const auto& [beaconName, measurements] : beaconMeasurements) {
         auto it = std::find_if(knownBeacons_.begin(), knownBeacons_.end(),
@@ -36,25 +36,35 @@ std::pair<double, double> Navigator::calculatePosition(
         if (it == knownBeacons_.end())
             continue;
 
+        lastSolve_.samples += measurements.size();
         std::vector<double> measuredDistances;
         for (const auto& measurement : measurements) {
-            double d = rssiToDistance(measurement.rssi_, measurement.txPower_);
-            if (d <= 30.0)
+            double d = rssiToDistance(measurement.rssi_, measurement.txPower_,
+                                      config_.path_loss_exponent,
+                                      config_.min_distance);
+            if (d <= config_.max_distance)
                 measuredDistances.push_back(d);  // отбрасываем шум
         }
         if (measuredDistances.empty())
             continue;
 
-        double filteredDistance = calculateMedian(measuredDistances);
-        double smoothedDistance =
-            updateMovingAverage(beaconName, filteredDistance);
+        double filteredDistance =
+            filteredMedian(measuredDistances, config_.iqr_k);
 
-        // ограничение скачка
-        constexpr double maxJump = 5.0;
+        // ограничение скорости: за такт сглаженное расстояние сдвигается
+        // не больше чем на max_jump, при настоящем перемещении догоняет
         auto prevIt = emaMap_.find(beaconName);
-        if (prevIt != emaMap_.end() &&
-            std::abs(smoothedDistance - prevIt->second) > maxJump) {
-            smoothedDistance = prevIt->second;
+        const bool hasPrevious = prevIt != emaMap_.end();
+        const double previous = hasPrevious ? prevIt->second : 0.0;
+
+        double smoothedDistance =
+            updateMovingAverage(beaconName, filteredDistance);
+        if (hasPrevious && config_.max_jump > 0 &&
+            std::abs(smoothedDistance - previous) > config_.max_jump) {
+            smoothedDistance =
+                previous + std::copysign(config_.max_jump,
+                                         smoothedDistance - previous);
+            emaMap_[beaconName] = smoothedDistance;
         }
 
         distances.emplace_back(*it, smoothedDistance);
@@ -63,36 +73,13 @@ std::pair<double, double> Navigator::calculatePosition(
     if (distances.size() < 3)
         throw std::runtime_error("Недостаточно маяков для триангуляции.");
 
-    auto rawPos = trilateration(distances);
+    lastSolve_.beacons = distances.size();
+    auto rawPos = trilaterate(distances, config_.trilateration,
+                              &lastSolve_.iterations);
 
     return applyPositionEMA(rawPos);
 }
 
-// --- calculateMedian с IQR ---
-double Navigator::calculateMedian(std::vector<double>& values) const {
-    if (values.empty())
-        throw std::runtime_error("Empty vector for median");
-
-    std::sort(values.begin(), values.end());
-    double q1 = values[values.size() / 4];
-    double q3 = values[3 * values.size() / 4];
-    double iqr = q3 - q1;
-
-    std::vector<double> filtered;
-    for (double v : values) {
-        if (v >= q1 - 1.5 * iqr && v <= q3 + 1.5 * iqr)
-            filtered.push_back(v);
-    }
-    if (filtered.empty())
-        filtered = values;
-
-    size_t n = filtered.size() / 2;
-    if (filtered.size() % 2 == 1)
-        return filtered[n];
-    else
-        return (filtered[n - 1] + filtered[n]) / 2.0;
-}
-
 // --- updateMovingAverage ---
 double Navigator::updateMovingAverage(const std::string& beaconName,
                                       double newValue) {
@@ -102,18 +89,11 @@ double Navigator::updateMovingAverage(const std::string& beaconName,
         return newValue;
     } else {
         double& current = it->second;
-        current = alpha_ * newValue + (1 - alpha_) * current;
+        current = config_.alpha * newValue + (1 - config_.alpha) * current;
         return current;
     }
 }
 
-// --- RSSI → расстояние (переписано) ---
-double Navigator::rssiToDistance(int rssi, int txPower) const {
-    constexpr double n = 3.0;  // indoor, меньше чем 3
-    double distance = std::pow(10.0, (txPower - rssi) / (10.0 * n));
-    return std::max(distance, 0.5);  // минимальное расстояние 0.5 м
-}
-
 // --- EMA координат ---
 std::pair<double, double> Navigator::applyPositionEMA(
     const std::pair<double, double>& newPos) const {
@@ -122,7 +102,7 @@ std::pair<double, double> Navigator::applyPositionEMA(
         lastPositionInitialized_ = true;
         return newPos;
     }
-    double alpha = 0.65;  // сильнее учитываем новое измерение
+    const double alpha = config_.position_alpha;
     lastPosition_.first =
         alpha * newPos.first + (1 - alpha) * lastPosition_.first;
     lastPosition_.second =
@@ -130,52 +110,4 @@ std::pair<double, double> Navigator::applyPositionEMA(
     return lastPosition_;
 }
 
-// --- Триангуляция с равными весами ---
-std::pair<double, double> Navigator::trilateration(
-    std::vector<std::pair<BLEBeacon, double>>& distances) const {
-    if (distances.size() < 3)
-        throw std::runtime_error(
-            "Недостаточно маяков для триангуляции (нужно минимум 3).");
-
-    // Старт: центр масс маяков
-    double x = 0, y = 0;
-    for (auto& d : distances) {
-        x += d.first.x_;
-        y += d.first.y_;
-    }
-    x /= distances.size();
-    y /= distances.size();
-
-    // Градиентный спуск
-    int maxIter = 200;
-    double lr = 0.2;
-    double tol = 1e-4;
-
-    for (int iter = 0; iter < maxIter; ++iter) {
-        double gx = 0, gy = 0;
-
-        for (auto& d : distances) {
-            double dx = x - d.first.x_;
-            double dy = y - d.first.y_;
-            double dist = std::sqrt(dx * dx + dy * dy) + 1e-9;
-            double err = dist - d.second;
-
-            // Равные веса
-            gx += err * dx / dist;
-            gy += err * dy / dist;
-        }
-
-        gx /= distances.size();
-        gy /= distances.size();
-
-        x -= lr * gx;
-        y -= lr * gy;
-
-        if (std::sqrt((lr * gx) * (lr * gx) + (lr * gy) * (lr * gy)) < tol)
-            break;
-    }
-
-    return {x, y};
-}
-
 }  // namespace navigator
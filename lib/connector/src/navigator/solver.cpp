@@ -0,0 +1,95 @@
+#include "navigator/solver.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace message_objects;
+
+namespace navigator {
+
+// --- calculateMedian с IQR ---
+double filteredMedian(std::vector<double>& values, double iqr_k) {
+    if (values.empty())
+        throw std::runtime_error("Empty vector for median");
+
+    std::sort(values.begin(), values.end());
+    double q1 = values[values.size() / 4];
+    double q3 = values[3 * values.size() / 4];
+    double iqr = q3 - q1;
+
+    std::vector<double> filtered;
+    for (double v : values) {
+        if (v >= q1 - iqr_k * iqr && v <= q3 + iqr_k * iqr)
+            filtered.push_back(v);
+    }
+    if (filtered.empty())
+        filtered = values;
+
+    size_t n = filtered.size() / 2;
+    if (filtered.size() % 2 == 1)
+        return filtered[n];
+    else
+        return (filtered[n - 1] + filtered[n]) / 2.0;
+}
+
+// --- RSSI → расстояние (переписано) ---
+double rssiToDistance(int rssi, int txPower, double n, double min_distance) {
+    // n = 3 для помещений, на открытом месте меньше
+    double distance = std::pow(10.0, (txPower - rssi) / (10.0 * n));
+    return std::max(distance, min_distance);
+}
+
+// --- Триангуляция с равными весами ---
+std::pair<double, double> trilaterate(
+    const std::vector<std::pair<BLEBeacon, double>>& distances,
+    const TrilaterationParams& params, int* iterations) {
+    if (distances.size() < 3)
+        throw std::runtime_error(
+            "Недостаточно маяков для триангуляции (нужно минимум 3).");
+
+    // Старт: центр масс маяков
+    double x = 0, y = 0;
+    for (const auto& d : distances) {
+        x += d.first.x_;
+        y += d.first.y_;
+    }
+    x /= distances.size();
+    y /= distances.size();
+
+    // Градиентный спуск
+    const int maxIter = params.max_iterations;
+    const double lr = params.learning_rate;
+    const double tol = params.tolerance;
+
+    int iter = 0;
+    while (iter < maxIter) {
+        ++iter;
+        double gx = 0, gy = 0;
+
+        for (const auto& d : distances) {
+            double dx = x - d.first.x_;
+            double dy = y - d.first.y_;
+            double dist = std::sqrt(dx * dx + dy * dy) + 1e-9;
+            double err = dist - d.second;
+
+            // Равные веса
+            gx += err * dx / dist;
+            gy += err * dy / dist;
+        }
+
+        gx /= distances.size();
+        gy /= distances.size();
+
+        x -= lr * gx;
+        y -= lr * gy;
+
+        if (std::sqrt((lr * gx) * (lr * gx) + (lr * gy) * (lr * gy)) < tol)
+            break;
+    }
+
+    if (iterations)
+        *iterations = iter;
+    return {x, y};
+}
+
+}  // namespace navigator
@@ -0,0 +1,282 @@
+#include "recorder/recorder.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QtEndian>
+
+#include <algorithm>
+
+#include "logging/log.h"
+
+namespace recorder {
+
+namespace {
+
+template <typename T>
+void appendLittleEndian(QByteArray& out, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+bool readLittleEndian(const QByteArray& data, qsizetype& offset, T& value) {
+    if (offset + static_cast<qsizetype>(sizeof(T)) > data.size()) {
+        return false;
+    }
+    value = qFromLittleEndian<T>(data.constData() + offset);
+    offset += sizeof(T);
+    return true;
+}
+
+void appendString8(QByteArray& out, const std::string& value) {
+    const auto size = static_cast<std::uint8_t>(std::min<std::size_t>(value.size(), 255));
+    out.append(static_cast<char>(size));
+    out.append(value.data(), size);
+}
+
+bool readString8(const QByteArray& data, qsizetype& offset, std::string& value) {
+    std::uint8_t size = 0;
+    if (!readLittleEndian(data, offset, size) || offset + size > data.size()) {
+        return false;
+    }
+    value.assign(data.constData() + offset, size);
+    offset += size;
+    return true;
+}
+
+}  // namespace
+
+void encodeSample(const AdvertSample& sample, QByteArray& out) {
+    const qsizetype start = out.size();
+    appendLittleEndian<std::uint16_t>(out, 0);  // длина, допишем ниже
+    appendLittleEndian<std::int64_t>(out, sample.timestamp_us);
+    out.append(static_cast<char>(sample.shard));
+    appendString8(out, sample.topic);
+    appendString8(out, sample.state.name_);
+    appendString8(out, sample.state.tag_);
+    appendLittleEndian<std::int16_t>(out, static_cast<std::int16_t>(sample.state.rssi_));
+    appendLittleEndian<std::int16_t>(out, static_cast<std::int16_t>(sample.state.txPower_));
+    appendString8(out, sample.state.gateway_);
+    appendLittleEndian<std::uint32_t>(out, sample.state.seq_);
+
+    const auto length = static_cast<std::uint16_t>(out.size() - start - 2);
+    qToLittleEndian(length, out.data() + start);
+}
+
+bool decodeSample(const QByteArray& data, qsizetype& offset,
+                  AdvertSample& sample) {
+    std::uint16_t length = 0;
+    if (!readLittleEndian(data, offset, length)) {
+        return false;
+    }
+    const qsizetype end = offset + length;
+    if (end > data.size()) {
+        return false;
+    }
+
+    std::int16_t rssi = 0;
+    std::int16_t tx_power = 0;
+    const bool ok = readLittleEndian(data, offset, sample.timestamp_us) &&
+                    readLittleEndian(data, offset, sample.shard) &&
+                    readString8(data, offset, sample.topic) &&
+                    readString8(data, offset, sample.state.name_) &&
+                    readString8(data, offset, sample.state.tag_) &&
+                    readLittleEndian(data, offset, rssi) &&
+                    readLittleEndian(data, offset, tx_power);
+    sample.state.rssi_ = rssi;
+    sample.state.txPower_ = tx_power;
+
+    // версия 1 без шлюза и seq
+    sample.state.gateway_.clear();
+    sample.state.seq_ = 0;
+    if (ok && offset < end) {
+        readString8(data, offset, sample.state.gateway_);
+        readLittleEndian(data, offset, sample.state.seq_);
+    }
+
+    // поля, добавленные в будущих версиях, пропускаются по длине
+    offset = end;
+    return ok;
+}
+
+Recorder::Recorder(RecorderOptions options, std::size_t shards)
+    : options_(std::move(options)),
+      // объём чанка не считаем точно: хватит оценки по числу записей
+      chunk_records_(std::max<std::size_t>(1, options_.chunk_bytes / 48)) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, shards); ++i) {
+        shards_.push_back(std::make_unique<ShardBuffer>());
+    }
+    openFile();
+    writer_thread_ = std::thread(&Recorder::writerLoop, this);
+}
+
+Recorder::~Recorder() {
+    stop();
+}
+
+void Recorder::record(std::size_t shard, const std::string& topic,
+                      const message_objects::BLEBeaconState& state) {
+    if (pending_.load(std::memory_order_relaxed) >= options_.max_pending) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    AdvertSample sample;
+    sample.timestamp_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    sample.shard = static_cast<std::uint8_t>(shard);
+    sample.topic = topic;
+    sample.state = state;
+
+    auto& buffer = *shards_[shard % shards_.size()];
+    {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.samples.push_back(std::move(sample));
+    }
+    // будим писателя, когда набрался чанк, а не ждём flush_interval_ms.
+    // Под writer_mutex_: иначе уведомление теряется между проверкой
+    // условия писателем и его засыпанием
+    if (pending_.fetch_add(1, std::memory_order_relaxed) + 1 == chunk_records_) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_cv_.notify_one();
+    }
+}
+
+void Recorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (should_stop_) {
+            return;
+        }
+        should_stop_ = true;
+    }
+    writer_cv_.notify_all();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    file_.close();
+}
+
+std::string Recorder::currentFile() const {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    return file_path_;
+}
+
+void Recorder::writerLoop() {
+    std::vector<AdvertSample> samples;
+    bool stopping = false;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(writer_mutex_);
+            writer_cv_.wait_for(
+                lock, std::chrono::milliseconds(options_.flush_interval_ms),
+                [this] { return should_stop_ || pending_ >= chunk_records_; });
+            stopping = should_stop_;
+        }
+
+        drain(samples);
+        std::sort(samples.begin(), samples.end(),
+                  [](const AdvertSample& a, const AdvertSample& b) {
+                      return a.timestamp_us < b.timestamp_us;
+                  });
+        // накопленное за задержку пишется несколькими чанками по chunk_bytes
+        for (std::size_t first = 0; first < samples.size(); first += chunk_records_) {
+            rotateIfNeeded();
+            writeChunk(std::span<const AdvertSample>(samples).subspan(
+                first, std::min(chunk_records_, samples.size() - first)));
+        }
+        samples.clear();
+    }
+}
+
+void Recorder::drain(std::vector<AdvertSample>& out) {
+    for (auto& shard : shards_) {
+        std::vector<AdvertSample> taken;
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            taken.swap(shard->samples);
+        }
+        pending_.fetch_sub(taken.size(), std::memory_order_relaxed);
+        out.insert(out.end(), std::make_move_iterator(taken.begin()),
+                   std::make_move_iterator(taken.end()));
+    }
+}
+
+void Recorder::writeChunk(std::span<const AdvertSample> samples) {
+    QByteArray raw;
+    raw.reserve(static_cast<qsizetype>(samples.size()) * 48);
+    for (const auto& sample : samples) {
+        encodeSample(sample, raw);
+    }
+    const QByteArray compressed = qCompress(raw, options_.compression_level);
+
+    QByteArray header;
+    appendLittleEndian<std::uint32_t>(header, static_cast<std::uint32_t>(compressed.size()));
+    appendLittleEndian<std::uint32_t>(header, static_cast<std::uint32_t>(samples.size()));
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (!file_.is_open()) {
+        dropped_.fetch_add(samples.size(), std::memory_order_relaxed);
+        return;
+    }
+    file_.write(header.constData(), header.size());
+    file_.write(compressed.constData(), compressed.size());
+    file_.flush();
+    if (!file_) {
+        // чанк мог записаться частично: файл закрываем, следующий чанк
+        // откроет новый, а оборванный хвост читатель отбросит
+        BACON_LOG_ERROR("recorder", "log write failed", "path", file_path_);
+        dropped_.fetch_add(samples.size(), std::memory_order_relaxed);
+        file_.close();
+        return;
+    }
+    file_bytes_ += header.size() + compressed.size();
+    recorded_.fetch_add(samples.size(), std::memory_order_relaxed);
+}
+
+void Recorder::rotateIfNeeded() {
+    bool rotate = false;
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        rotate = !file_.is_open() || file_bytes_ >= options_.max_file_bytes ||
+                 (options_.max_file_seconds > 0 &&
+                  std::chrono::steady_clock::now() - file_opened_ >=
+                      std::chrono::seconds(options_.max_file_seconds));
+    }
+    if (rotate) {
+        openFile();
+    }
+}
+
+void Recorder::openFile() {
+    QDir().mkpath(QString::fromStdString(options_.directory));
+
+    // время до миллисекунд, чтобы быстрая ротация не перезаписала файл
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+    const std::string path = options_.directory + "/" + options_.prefix + "-" +
+                             stamp.toStdString() + ".blog";
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        BACON_LOG_ERROR("recorder", "cannot open log", "path", path);
+        return;
+    }
+
+    QByteArray header(kLogMagic, sizeof(kLogMagic));
+    appendLittleEndian<std::uint32_t>(header, kLogVersion);
+    file_.write(header.constData(), header.size());
+
+    file_path_ = path;
+    file_bytes_ = header.size();
+    file_opened_ = std::chrono::steady_clock::now();
+}
+
+}  // namespace recorder
@@ -0,0 +1,185 @@
+#include "recorder/replayer.h"
+
+#include "mqtt_connector/mqtt_client.h"
+
+#include <QtEndian>
+
+#include <json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace recorder {
+
+namespace {
+
+constexpr std::size_t kChunkHeaderSize = 2 * sizeof(std::uint32_t);
+
+/**
+ * Измерение в виде, в котором его присылает esp
+ */
+std::string advertPayload(const message_objects::BLEBeaconState& state) {
+    nlohmann::json json_data;
+    json_data["name"] = state.name_;
+    json_data["rssi"] = state.rssi_;
+    json_data["tx_power"] = state.txPower_;
+    json_data["tag"] = state.tag_;
+    if (!state.gateway_.empty()) {
+        json_data["gateway"] = state.gateway_;
+    }
+    if (state.seq_ != 0) {
+        json_data["seq"] = state.seq_;
+    }
+    return json_data.dump();
+}
+
+}  // namespace
+
+LogReader::LogReader(const std::string& path)
+    : file_(path, std::ios::binary) {
+    char magic[sizeof(kLogMagic)] = {};
+    char version[sizeof(std::uint32_t)] = {};
+    file_.read(magic, sizeof(magic));
+    file_.read(version, sizeof(version));
+    if (!file_ || std::memcmp(magic, kLogMagic, sizeof(kLogMagic)) != 0 ||
+        qFromLittleEndian<std::uint32_t>(version) > kLogVersion) {
+        throw std::runtime_error("Not a bacon advert log: " + path);
+    }
+}
+
+bool LogReader::next(AdvertSample& sample) {
+    while (offset_ >= chunk_.size()) {
+        if (!readChunk()) {
+            return false;
+        }
+    }
+    return decodeSample(chunk_, offset_, sample);
+}
+
+bool LogReader::readChunk() {
+    char header[kChunkHeaderSize];
+    if (!file_.read(header, sizeof(header))) {
+        return false;
+    }
+    const auto compressed_size = qFromLittleEndian<std::uint32_t>(header);
+
+    QByteArray compressed(static_cast<qsizetype>(compressed_size), Qt::Uninitialized);
+    if (!file_.read(compressed.data(), compressed.size())) {
+        return false;  // оборванный последний чанк
+    }
+    chunk_ = qUncompress(compressed);
+    offset_ = 0;
+    return !chunk_.isEmpty() || compressed_size == 0;
+}
+
+CsvReader::CsvReader(const std::string& path, std::string topic)
+    : file_(path), topic_(std::move(topic)) {
+    if (!file_.is_open()) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+}
+
+bool CsvReader::next(AdvertSample& sample) {
+    std::string line;
+    while (std::getline(file_, line)) {
+        std::stringstream ss(line);
+        std::string ts, name, rssi, tx_power, tag;
+        if (!std::getline(ss, ts, ',') || !std::getline(ss, name, ',') ||
+            !std::getline(ss, rssi, ',') || !std::getline(ss, tx_power, ',')) {
+            continue;
+        }
+        std::getline(ss, tag, ',');
+        try {
+            sample.timestamp_us = std::stoll(ts) * 1000;
+            sample.state.rssi_ = std::stoi(rssi);
+            sample.state.txPower_ = std::stoi(tx_power);
+        } catch (const std::exception&) {
+            continue;  // заголовок или мусор
+        }
+        sample.shard = 0;
+        sample.topic = topic_;
+        sample.state.name_ = name;
+        sample.state.tag_ = tag.empty() ? message_objects::kDefaultTag : tag;
+        return true;
+    }
+    return false;
+}
+
+std::unique_ptr<SampleSource> openSamples(const std::string& path,
+                                          const std::string& csv_topic) {
+    std::ifstream probe(path, std::ios::binary);
+    char magic[sizeof(kLogMagic)] = {};
+    probe.read(magic, sizeof(magic));
+    if (probe && std::memcmp(magic, kLogMagic, sizeof(kLogMagic)) == 0) {
+        return std::make_unique<LogReader>(path);
+    }
+    return std::make_unique<CsvReader>(path, csv_topic);
+}
+
+Replayer::Replayer(mqtt_connector::MqttClient* client, ReplayOptions options)
+    : client_(client), options_(options) {}
+
+ReplayStats Replayer::run(SampleSource& source) {
+    using clock = std::chrono::steady_clock;
+
+    ReplayStats stats;
+    const auto wall_start = clock::now();
+    const auto tick_us = static_cast<std::int64_t>(
+        1'000'000.0 / std::max(0.001f, client_->frequency()));
+
+    AdvertSample sample;
+    std::int64_t first_us = 0;
+    std::int64_t last_us = 0;
+    std::int64_t tick_end_us = 0;
+
+    while (source.next(sample)) {
+        if (stats.samples == 0) {
+            first_us = sample.timestamp_us;
+            tick_end_us = first_us + tick_us;
+        }
+        last_us = sample.timestamp_us;
+
+        // закрываем такты, которые целиком лежат до этого измерения
+        while (sample.timestamp_us >= tick_end_us) {
+            stats.positions += tick(tick_end_us / 1000);
+            ++stats.ticks;
+            tick_end_us += tick_us;
+        }
+
+        if (options_.speed > 0) {
+            const auto due =
+                wall_start + std::chrono::microseconds(static_cast<std::int64_t>(
+                                 (sample.timestamp_us - first_us) / options_.speed));
+            std::this_thread::sleep_until(due);
+        }
+
+        mqtt_connector::Message message(sample.topic, advertPayload(sample.state));
+        message.shard = sample.shard;
+        message.timestamp_ms = std::max<std::int64_t>(1, sample.timestamp_us / 1000);
+        client_->onMessageReceived(message);
+        ++stats.samples;
+    }
+
+    if (stats.samples > 0) {
+        stats.positions += tick(tick_end_us / 1000);
+        ++stats.ticks;
+    }
+
+    stats.wall_seconds =
+        std::chrono::duration<double>(clock::now() - wall_start).count();
+    stats.capture_seconds = (last_us - first_us) / 1e6;
+    return stats;
+}
+
+std::size_t Replayer::tick(std::int64_t tick_ms) {
+    if (options_.on_tick) {
+        options_.on_tick(tick_ms);
+    }
+    return client_->processTick(tick_ms);
+}
+
+}  // namespace recorder
@@ -0,0 +1,176 @@
+#include "simulator/traffic_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace simulator {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMinDistance = 0.1;  // ближе маяка метка не подходит
+
+}  // namespace
+
+TrafficGenerator::TrafficGenerator(
+    std::vector<message_objects::BLEBeacon> beacons, GeneratorOptions options,
+    int first_tag)
+    : beacons_(std::move(beacons)),
+      options_(std::move(options)),
+      rng_(options_.seed) {
+    if (beacons_.empty()) {
+        throw std::invalid_argument("Traffic generator needs beacons");
+    }
+
+    min_x_ = max_x_ = beacons_.front().x_;
+    min_y_ = max_y_ = beacons_.front().y_;
+    for (const auto& beacon : beacons_) {
+        min_x_ = std::min(min_x_, beacon.x_);
+        max_x_ = std::max(max_x_, beacon.x_);
+        min_y_ = std::min(min_y_, beacon.y_);
+        max_y_ = std::max(max_y_, beacon.y_);
+    }
+
+    for (int g = 0; g < options_.gateways; ++g) {
+        gateway_names_.push_back("gw-" + std::to_string(g));
+    }
+
+    tags_.resize(options_.tags);
+    for (int i = 0; i < options_.tags; ++i) {
+        Tag& tag = tags_[i];
+        tag.name = options_.tag_prefix + "-" + std::to_string(first_tag + i);
+        tag.x = min_x_ + uniform_(rng_) * (max_x_ - min_x_);
+        tag.y = min_y_ + uniform_(rng_) * (max_y_ - min_y_);
+        tag.phase = uniform_(rng_) * 2 * kPi;
+        tag.shadow.assign(beacons_.size(), 0.0);
+        for (auto& shadow : tag.shadow) {
+            shadow = normal_(rng_) * options_.radio.shadowing_sigma_db;
+        }
+        pickWaypoint(tag);
+    }
+}
+
+TrafficGenerator TrafficGenerator::forWorker(
+    const std::vector<message_objects::BLEBeacon>& beacons,
+    GeneratorOptions options, int worker, int workers) {
+    const int total = options.tags;
+    const int first = total * worker / workers;
+    const int last = total * (worker + 1) / workers;
+    options.tags = last - first;
+    // разные, но воспроизводимые потоки случайных чисел
+    options.seed = options.seed * 0x9E3779B97F4A7C15ull + worker;
+    return TrafficGenerator(beacons, std::move(options), first);
+}
+
+std::size_t TrafficGenerator::step(const Sink& sink) {
+    const double dt = options_.advert_interval;
+    time_ += dt;
+    ++step_;
+
+    message_objects::BLEBeaconState state;
+    state.txPower_ = options_.radio.tx_power;
+
+    std::size_t emitted = 0;
+    for (auto& tag : tags_) {
+        move(tag, dt);
+        state.tag_ = tag.name;
+        for (std::size_t b = 0; b < beacons_.size(); ++b) {
+            const auto& beacon = beacons_[b];
+            const double distance =
+                std::max(kMinDistance, std::hypot(tag.x - beacon.x_, tag.y - beacon.y_));
+            state.name_ = beacon.name_;
+            if (options_.gateways <= 1) {
+                const int value = rssi(distance, tag.shadow[b]);
+                if (value < options_.radio.sensitivity) {
+                    continue;
+                }
+                state.rssi_ = value;
+                sink(state);
+                ++emitted;
+                continue;
+            }
+            const double mean = meanRssi(distance, tag.shadow[b]);
+            state.seq_ = step_;
+            for (int g = 0; g < options_.gateways; ++g) {
+                const int value = static_cast<int>(std::lround(mean + fadingDb()));
+                if (value < options_.radio.sensitivity) {
+                    continue;
+                }
+                state.gateway_ = gateway_names_[g];
+                state.rssi_ = value;
+                sink(state);
+                ++emitted;
+            }
+        }
+    }
+    return emitted;
+}
+
+std::pair<double, double> TrafficGenerator::position(int tag) const {
+    return {tags_.at(tag).x, tags_.at(tag).y};
+}
+
+int TrafficGenerator::rssi(double distance, double& shadow) {
+    const double mean = meanRssi(distance, shadow);
+    return static_cast<int>(std::lround(mean + fadingDb()));
+}
+
+double TrafficGenerator::meanRssi(double distance, double& shadow) {
+    const RadioModel& radio = options_.radio;
+
+    // затенение меняется медленно: AR(1) с заданной СКО
+    const double rho = radio.shadowing_correlation;
+    shadow = rho * shadow +
+             std::sqrt(1.0 - rho * rho) * radio.shadowing_sigma_db * normal_(rng_);
+
+    return radio.tx_power - 10.0 * radio.path_loss_exponent * std::log10(distance) +
+           shadow;
+}
+
+double TrafficGenerator::fadingDb() {
+    // замирания Райса: прямой луч + рассеянная гауссова часть
+    const double k = options_.radio.rician_k;
+    const double los = std::sqrt(k / (k + 1.0));
+    const double scatter = std::sqrt(1.0 / (2.0 * (k + 1.0)));
+    const double re = los + scatter * normal_(rng_);
+    const double im = scatter * normal_(rng_);
+    return 10.0 * std::log10(std::max(re * re + im * im, 1e-6));
+}
+
+void TrafficGenerator::move(Tag& tag, double dt) {
+    const double step = options_.speed * dt;
+    switch (options_.trajectory) {
+        case Trajectory::CIRCLE: {
+            const double cx = (min_x_ + max_x_) / 2;
+            const double cy = (min_y_ + max_y_) / 2;
+            const double radius =
+                std::max(1.0, std::min(max_x_ - min_x_, max_y_ - min_y_) / 3);
+            tag.phase += step / radius;
+            tag.x = cx + radius * std::cos(tag.phase);
+            tag.y = cy + radius * std::sin(tag.phase);
+            break;
+        }
+        case Trajectory::WAYPOINTS: {
+            const double dx = tag.target_x - tag.x;
+            const double dy = tag.target_y - tag.y;
+            const double left = std::hypot(dx, dy);
+            if (left <= step) {
+                tag.x = tag.target_x;
+                tag.y = tag.target_y;
+                pickWaypoint(tag);
+            } else {
+                tag.x += dx / left * step;
+                tag.y += dy / left * step;
+            }
+            break;
+        }
+    }
+}
+
+void TrafficGenerator::pickWaypoint(Tag& tag) {
+    tag.target_x = min_x_ + uniform_(rng_) * (max_x_ - min_x_);
+    tag.target_y = min_y_ + uniform_(rng_) * (max_y_ - min_y_);
+}
+
+}  // namespace simulator
@@ -0,0 +1,287 @@
+#include "tracing/trace.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace tracing {
+
+namespace {
+
+// буферы завершившихся потоков храним для дампа, но не бесконечно:
+// Paho пересоздаёт потоки при переподключении
+constexpr std::size_t kMaxRetiredBuffers = 32;
+
+struct Event {
+    std::uint64_t start;
+    std::uint64_t end;
+    std::uint64_t id;
+    Stage stage;
+    char tag[16];
+};
+
+/**
+ * Ячейка с seqlock: нечётный seq - идёт запись, чётный 2n+2 - в ячейке
+ * событие номер n
+ */
+struct Slot {
+    std::atomic<std::uint64_t> seq{0};
+    Event event;
+};
+
+struct ThreadBuffer {
+    std::uint32_t tid = 0;
+    std::string name;
+    std::atomic<std::uint64_t> next{0};
+    std::atomic<bool> retired{false};
+    std::array<Slot, kEventsPerThread> slots;
+};
+
+class Buffers {
+   public:
+    static Buffers& instance() {
+        static Buffers buffers;
+        return buffers;
+    }
+
+    std::shared_ptr<ThreadBuffer> registerThread() {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->tid = ++next_tid_;
+        buffer->name = name[0] ? name : "thread-" + std::to_string(buffer->tid);
+
+        std::size_t retired = std::count_if(
+            buffers_.begin(), buffers_.end(),
+            [](const auto& b) { return b->retired.load(std::memory_order_relaxed); });
+        for (auto it = buffers_.begin();
+             retired > kMaxRetiredBuffers && it != buffers_.end();) {
+            if ((*it)->retired.load(std::memory_order_relaxed)) {
+                it = buffers_.erase(it);
+                --retired;
+            } else {
+                ++it;
+            }
+        }
+        buffers_.push_back(buffer);
+        return buffer;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffers_;
+    }
+
+    // опорная точка для перевода тиков TSC в микросекунды
+    const std::uint64_t origin_ticks = now();
+    const std::chrono::steady_clock::time_point origin_time =
+        std::chrono::steady_clock::now();
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::uint32_t next_tid_ = 0;
+};
+
+struct ThreadHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ~ThreadHolder() {
+        if (buffer) buffer->retired.store(true, std::memory_order_relaxed);
+    }
+};
+
+thread_local ThreadHolder t_holder;
+thread_local std::uint64_t t_current_id = 0;
+std::atomic<std::uint64_t> g_next_id{0};
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::RECEIVE: return "receive";
+        case Stage::ENQUEUE: return "enqueue";
+        case Stage::TICK: return "tick";
+        case Stage::SOLVE: return "solve";
+        case Stage::EMIT: return "emit";
+        case Stage::MODEL_APPEND: return "model append";
+        case Stage::SCENE_UPDATE: return "scene update";
+        case Stage::SCENE_PAINT: return "scene paint";
+    }
+    return "?";
+}
+
+// роль этапа в стрелке позиции: начало, промежуточный шаг, конец
+char flowPhase(Stage stage) {
+    switch (stage) {
+        case Stage::SOLVE: return 's';
+        case Stage::EMIT:
+        case Stage::MODEL_APPEND: return 't';
+        case Stage::SCENE_PAINT: return 'f';
+        default: return 0;
+    }
+}
+
+void writeJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void setEnabled(bool enabled) {
+    Buffers::instance();  // опорная точка - до первого события
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void record(Stage stage, std::uint64_t start, std::uint64_t end, std::uint64_t id,
+            std::string_view tag) {
+    auto& holder = t_holder;
+    if (!holder.buffer) holder.buffer = Buffers::instance().registerThread();
+    ThreadBuffer& buffer = *holder.buffer;
+
+    const std::uint64_t n = buffer.next.load(std::memory_order_relaxed);
+    Slot& slot = buffer.slots[n % kEventsPerThread];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = slot.event;
+    event.start = start;
+    event.end = end;
+    event.id = id;
+    event.stage = stage;
+    const std::size_t length = std::min(tag.size(), sizeof(event.tag) - 1);
+    std::copy_n(tag.data(), length, event.tag);
+    event.tag[length] = '\0';
+
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    buffer.next.store(n + 1, std::memory_order_release);
+}
+
+std::uint64_t nextId() {
+    return g_next_id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::uint64_t currentId() {
+    return t_current_id;
+}
+
+void setCurrentId(std::uint64_t id) {
+    t_current_id = id;
+}
+
+std::string chromeTrace() {
+    auto& buffers = Buffers::instance();
+    const std::uint64_t ticks = now() - buffers.origin_ticks;
+    const auto elapsed = std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - buffers.origin_time)
+                             .count();
+    const double ticks_per_us = elapsed > 0 && ticks > 0 ? ticks / elapsed : 1.0;
+    const auto micros = [&](std::uint64_t t) {
+        return (static_cast<double>(t) - static_cast<double>(buffers.origin_ticks)) /
+               ticks_per_us;
+    };
+
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    const auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    std::vector<Event> events;
+    for (const auto& buffer : buffers.snapshot()) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer->name);
+        out << "}}";
+
+        events.clear();
+        const std::uint64_t next = buffer->next.load(std::memory_order_acquire);
+        const std::uint64_t begin = next > kEventsPerThread ? next - kEventsPerThread : 0;
+        for (std::uint64_t n = begin; n < next; ++n) {
+            const Slot& slot = buffer->slots[n % kEventsPerThread];
+            const std::uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * n + 2) continue;
+            Event event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+            events.push_back(event);
+        }
+        std::stable_sort(events.begin(), events.end(),
+                         [](const Event& a, const Event& b) { return a.start < b.start; });
+
+        for (std::size_t i = 0; i < events.size();) {
+            // пачка позиций одного этапа (MODEL_APPEND, SCENE_PAINT) - один
+            // интервал, к которому сходятся стрелки всех её позиций
+            std::size_t j = i + 1;
+            while (j < events.size() && events[j].stage == events[i].stage &&
+                   events[j].start == events[i].start && events[j].end == events[i].end) {
+                ++j;
+            }
+            const Event& slice = events[i];
+            separator();
+            out << "{\"name\":\"" << stageName(slice.stage)
+                << "\",\"cat\":\"bacon\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << micros(slice.start)
+                << ",\"dur\":" << micros(slice.end) - micros(slice.start)
+                << ",\"args\":{";
+            if (j - i > 1) {
+                out << "\"positions\":" << j - i;
+            } else if (slice.id) {
+                out << "\"id\":" << slice.id;
+            }
+            if (slice.tag[0]) {
+                out << (j - i > 1 || slice.id ? "," : "") << "\"tag\":";
+                writeJsonString(out, slice.tag);
+            }
+            out << "}}";
+
+            if (const char phase = flowPhase(slice.stage)) {
+                for (std::size_t k = i; k < j; ++k) {
+                    if (events[k].id == 0) continue;
+                    separator();
+                    out << "{\"name\":\"position\",\"cat\":\"bacon\",\"ph\":\"" << phase
+                        << "\",\"id\":" << events[k].id << ",\"pid\":1,\"tid\":"
+                        << buffer->tid << ",\"ts\":" << micros(slice.start);
+                    if (phase == 'f') out << ",\"bp\":\"e\"";
+                    out << "}";
+                }
+            }
+            i = j;
+        }
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+bool dumpChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << chromeTrace();
+    return static_cast<bool>(file);
+}
+
+}  // namespace tracing
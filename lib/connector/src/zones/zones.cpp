@@ -0,0 +1,291 @@
+#include "zones/zones.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <json.hpp>
+
+namespace zones {
+
+namespace {
+
+// больше ячеек не заводим: у разреженных зон на огромной площади
+// шаг сетки растёт
+constexpr double kMaxCells = 1 << 22;
+constexpr double kMinCell = 0.25;
+
+double segmentDistance(double x, double y, double x0, double y0, double x1, double y1) {
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    const double length2 = dx * dx + dy * dy;
+    double t = length2 > 0 ? ((x - x0) * dx + (y - y0) * dy) / length2 : 0.0;
+    t = std::clamp(t, 0.0, 1.0);
+    return std::hypot(x - (x0 + t * dx), y - (y0 + t * dy));
+}
+
+}  // namespace
+
+const char* eventName(EventType type) {
+    switch (type) {
+        case EventType::ENTER: return "enter";
+        case EventType::EXIT: return "exit";
+        case EventType::DWELL: return "dwell";
+    }
+    return "?";
+}
+
+std::string encodeJson(const ZoneEvent& event) {
+    nlohmann::json json_data;
+    json_data["event"] = eventName(event.type);
+    json_data["tag"] = event.tag;
+    json_data["zone"] = event.zone;
+    json_data["x"] = event.x;
+    json_data["y"] = event.y;
+    json_data["ts"] = event.timestamp_ms;
+    if (event.type != EventType::ENTER) {
+        json_data["inside_ms"] = event.inside_ms;
+    }
+    return json_data.dump();
+}
+
+ZoneIndex::ZoneIndex(std::vector<Zone> zones, const ZoneOptions& options)
+    : options_(options) {
+    // вырожденные многоугольники не проверяются
+    std::erase_if(zones, [](const Zone& zone) { return zone.polygon.size() < 3; });
+    zones_ = std::move(zones);
+    options_.hysteresis_m = std::max(0.0, options_.hysteresis_m);
+
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    Bounds all{kInf, kInf, -kInf, -kInf};
+    double size_sum = 0;
+    edge_start_.reserve(zones_.size() + 1);
+    for (const auto& zone : zones_) {
+        Bounds b{kInf, kInf, -kInf, -kInf};
+        edge_start_.push_back(static_cast<std::uint32_t>(edges_.size()));
+        for (std::size_t i = 0; i < zone.polygon.size(); ++i) {
+            const Point& p0 = zone.polygon[i];
+            const Point& p1 = zone.polygon[(i + 1) % zone.polygon.size()];
+            const double dy = p1.y - p0.y;
+            edges_.push_back({p0.x, p0.y, p1.x, p1.y, dy != 0 ? (p1.x - p0.x) / dy : 0.0});
+            b = {std::min(b.min_x, p0.x), std::min(b.min_y, p0.y), std::max(b.max_x, p0.x),
+                 std::max(b.max_y, p0.y)};
+        }
+        bounds_.push_back(b);
+        size_sum += std::max(b.max_x - b.min_x, b.max_y - b.min_y);
+        all = {std::min(all.min_x, b.min_x), std::min(all.min_y, b.min_y),
+               std::max(all.max_x, b.max_x), std::max(all.max_y, b.max_y)};
+    }
+    edge_start_.push_back(static_cast<std::uint32_t>(edges_.size()));
+
+    if (zones_.empty()) {
+        cell_start_.assign(1, 0);
+        return;
+    }
+
+    // полоса гистерезиса в сетку не входит: зоны, где метка уже числится,
+    // проверяются и без сетки
+    origin_x_ = all.min_x;
+    origin_y_ = all.min_y;
+    const double width = all.max_x - all.min_x;
+    const double height = all.max_y - all.min_y;
+    cell_ = options_.cell_size > 0 ? options_.cell_size
+                                   : std::max(kMinCell, size_sum / zones_.size());
+    cell_ = std::max(cell_, std::sqrt(width * height / kMaxCells));
+    columns_ = static_cast<std::int64_t>(width / cell_) + 1;
+    rows_ = static_cast<std::int64_t>(height / cell_) + 1;
+
+    const auto cellRange = [&](const Bounds& b) {
+        const auto clampColumn = [&](double x) {
+            return std::clamp<std::int64_t>(
+                static_cast<std::int64_t>((x - origin_x_) / cell_), 0, columns_ - 1);
+        };
+        const auto clampRow = [&](double y) {
+            return std::clamp<std::int64_t>(
+                static_cast<std::int64_t>((y - origin_y_) / cell_), 0, rows_ - 1);
+        };
+        return std::array<std::int64_t, 4>{clampColumn(b.min_x), clampRow(b.min_y),
+                                           clampColumn(b.max_x), clampRow(b.max_y)};
+    };
+
+    // два прохода: размеры ячеек, затем заполнение
+    cell_start_.assign(static_cast<std::size_t>(columns_ * rows_) + 1, 0);
+    for (const auto& b : bounds_) {
+        const auto [c0, r0, c1, r1] = cellRange(b);
+        for (std::int64_t r = r0; r <= r1; ++r) {
+            for (std::int64_t c = c0; c <= c1; ++c) {
+                ++cell_start_[r * columns_ + c + 1];
+            }
+        }
+    }
+    for (std::size_t i = 1; i < cell_start_.size(); ++i) {
+        cell_start_[i] += cell_start_[i - 1];
+    }
+    cell_zones_.resize(cell_start_.back());
+    std::vector<std::uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+    for (std::uint32_t zone = 0; zone < bounds_.size(); ++zone) {
+        const auto [c0, r0, c1, r1] = cellRange(bounds_[zone]);
+        for (std::int64_t r = r0; r <= r1; ++r) {
+            for (std::int64_t c = c0; c <= c1; ++c) {
+                cell_zones_[fill[r * columns_ + c]++] = zone;
+            }
+        }
+    }
+}
+
+std::pair<const std::uint32_t*, std::size_t> ZoneIndex::candidates(double x, double y) const {
+    const double fx = (x - origin_x_) / cell_;
+    const double fy = (y - origin_y_) / cell_;
+    if (!(fx >= 0 && fy >= 0 && fx < static_cast<double>(columns_) &&
+          fy < static_cast<double>(rows_))) {
+        return {nullptr, 0};
+    }
+    const auto cell = static_cast<std::int64_t>(fy) * columns_ + static_cast<std::int64_t>(fx);
+    return {cell_zones_.data() + cell_start_[cell], cell_start_[cell + 1] - cell_start_[cell]};
+}
+
+bool ZoneIndex::contains(std::uint32_t zone, double x, double y) const {
+    const Bounds& b = bounds_[zone];
+    if (x < b.min_x || x > b.max_x || y < b.min_y || y > b.max_y) {
+        return false;
+    }
+    // чётность пересечений луча вправо от точки с рёбрами
+    bool inside = false;
+    for (std::uint32_t i = edge_start_[zone]; i < edge_start_[zone + 1]; ++i) {
+        const Edge& e = edges_[i];
+        if ((e.y0 > y) != (e.y1 > y) && x < e.x0 + (y - e.y0) * e.dx_dy) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+double ZoneIndex::distanceToBoundary(std::uint32_t zone, double x, double y) const {
+    double best = std::numeric_limits<double>::infinity();
+    for (std::uint32_t i = edge_start_[zone]; i < edge_start_[zone + 1]; ++i) {
+        const Edge& e = edges_[i];
+        best = std::min(best, segmentDistance(x, y, e.x0, e.y0, e.x1, e.y1));
+    }
+    return best;
+}
+
+void ZoneEngine::setZones(std::vector<Zone> zones, const ZoneOptions& options) {
+    index_.store(std::make_shared<const ZoneIndex>(std::move(zones), options),
+                 std::memory_order_release);
+}
+
+std::shared_ptr<const ZoneIndex> ZoneEngine::index() const {
+    return index_.load(std::memory_order_acquire);
+}
+
+std::size_t ZoneEngine::update(const std::string& tag, double x, double y,
+                               std::int64_t now_ms, std::vector<ZoneEvent>& events) {
+    last_tested_ = 0;
+    auto index = index_.load(std::memory_order_acquire);
+    if (!index) {
+        return 0;
+    }
+    TagState& state = tags_[tag];
+    if (state.index != index) {
+        state.index = index;
+        state.zones.clear();
+    }
+    state.x = x;
+    state.y = y;
+    state.seen_ms = now_ms;
+
+    const ZoneOptions& options = index->options();
+    const int confirm = std::max(1, options.confirm_updates);
+    const std::size_t before = events.size();
+    const auto emitEvent = [&](EventType type, const Tracked& tracked) {
+        const Zone& zone = index->zones()[tracked.zone];
+        events.push_back({type, tag, zone.name, x, y, now_ms,
+                          type == EventType::ENTER ? 0 : now_ms - tracked.entered_ms});
+    };
+    const auto dwell = [&](Tracked& tracked) {
+        const double dwell_s = index->zones()[tracked.zone].dwell_s;
+        if (!tracked.dwelled && dwell_s > 0 &&
+            now_ms - tracked.entered_ms >= static_cast<std::int64_t>(dwell_s * 1000)) {
+            tracked.dwelled = true;
+            emitEvent(EventType::DWELL, tracked);
+        }
+    };
+
+    // зоны, в которых метка числится или в которые входит
+    for (auto it = state.zones.begin(); it != state.zones.end();) {
+        ++last_tested_;
+        const bool in = index->contains(it->zone, x, y);
+        if (it->inside) {
+            // выход - только за полосой гистерезиса
+            const bool out = !in && index->distanceToBoundary(it->zone, x, y) >
+                                        options.hysteresis_m;
+            if (!out) {
+                it->streak = 0;
+                dwell(*it);
+            } else if (++it->streak >= confirm) {
+                emitEvent(EventType::EXIT, *it);
+                it = state.zones.erase(it);
+                continue;
+            }
+        } else if (!in) {
+            it = state.zones.erase(it);
+            continue;
+        } else if (++it->streak >= confirm) {
+            it->inside = true;
+            it->streak = 0;
+            emitEvent(EventType::ENTER, *it);
+            dwell(*it);
+        }
+        ++it;
+    }
+
+    // новые зоны - только из ячейки точки
+    const auto [ids, count] = index->candidates(x, y);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t zone = ids[i];
+        if (std::any_of(state.zones.begin(), state.zones.end(),
+                        [zone](const Tracked& t) { return t.zone == zone; })) {
+            continue;
+        }
+        ++last_tested_;
+        if (!index->contains(zone, x, y)) {
+            continue;
+        }
+        Tracked tracked{zone, false, 1, now_ms, false};
+        if (confirm <= 1) {
+            tracked.inside = true;
+            tracked.streak = 0;
+            emitEvent(EventType::ENTER, tracked);
+            dwell(tracked);
+        }
+        state.zones.push_back(tracked);
+    }
+    return events.size() - before;
+}
+
+std::size_t ZoneEngine::evictIdle(std::int64_t now_ms, std::int64_t idle_ms,
+                                  std::vector<ZoneEvent>& events) {
+    const auto index = index_.load(std::memory_order_acquire);
+    std::size_t evicted = 0;
+    for (auto it = tags_.begin(); it != tags_.end();) {
+        const TagState& state = it->second;
+        if (now_ms - state.seen_ms <= idle_ms) {
+            ++it;
+            continue;
+        }
+        // после смены зон состояние сбрасывается без выходов, как в update()
+        for (const Tracked& tracked : state.zones) {
+            if (tracked.inside && state.index == index) {
+                events.push_back({EventType::EXIT, it->first,
+                                  state.index->zones()[tracked.zone].name, state.x,
+                                  state.y, now_ms, now_ms - tracked.entered_ms});
+            }
+        }
+        it = tags_.erase(it);
+        ++evicted;
+    }
+    return evicted;
+}
+
+}  // namespace zones
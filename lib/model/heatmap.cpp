@@ -0,0 +1,454 @@
+#include "heatmap.hpp"
+
+#include <QColor>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "logging/log.h"
+
+namespace {
+
+constexpr quint32 kMagic = 0x48544d50;  // "HTMP"
+constexpr qint32 kVersion = 1;
+
+// множитель забывания живого слоя не растёт дальше e^30, иначе
+// значения переводятся к новой точке отсчёта
+constexpr double kMaxLiveExponent = 30.0;
+
+// синий -> зелёный -> жёлтый -> красный, занятые ячейки плотнее
+const std::array<QRgb, 256>& palette() {
+    static const std::array<QRgb, 256> colors = [] {
+        const QColor stops[] = {QColor("#2c7bb6"), QColor("#00a6ca"), QColor("#00ccbc"),
+                                QColor("#90eb9d"), QColor("#ffff8c"), QColor("#f9d057"),
+                                QColor("#f29e2e"), QColor("#e76818"), QColor("#d7191c")};
+        const int kStops = static_cast<int>(std::size(stops));
+        std::array<QRgb, 256> result{};
+        for (int i = 1; i < 256; ++i) {
+            const double t = i / 255.0;
+            const double pos = t * (kStops - 1);
+            const int k = std::min(kStops - 2, static_cast<int>(pos));
+            const double f = pos - k;
+            const auto mix = [f](int a, int b) {
+                return static_cast<int>(std::lround(a + (b - a) * f));
+            };
+            const QColor& a = stops[k];
+            const QColor& b = stops[k + 1];
+            const int alpha = static_cast<int>(std::lround(60 + 170 * t));
+            result[i] = qPremultiply(qRgba(mix(a.red(), b.red()), mix(a.green(), b.green()),
+                                           mix(a.blue(), b.blue()), alpha));
+        }
+        return result;
+    }();
+    return colors;
+}
+
+}  // namespace
+
+HeatmapTiles::HeatmapTiles(const Options& options)
+    : m_options(options),
+      m_liveTauMs(std::max(1.0, options.liveHalfLife) * 1000.0 / std::log(2.0)) {
+    m_options.cellSize = std::max(0.01, m_options.cellSize);
+    for (int level = 0; level < kLevels; ++level) {
+        auto& l = m_levels[level];
+        l.cell = m_options.cellSize * (1 << level);
+        const double tileSize = l.cell * kTileSide;
+        l.tilesX = std::max(1, static_cast<int>(std::ceil(m_options.area.width() / tileSize)));
+        l.tilesY = std::max(1, static_cast<int>(std::ceil(m_options.area.height() / tileSize)));
+    }
+    // самый грубый уровень помещается целиком, плюс хотя бы по плитке на остальные
+    const auto& coarsest = m_levels[kLevels - 1];
+    m_options.maxTiles = std::max<qsizetype>(
+        m_options.maxTiles, qsizetype(coarsest.tilesX) * coarsest.tilesY + kLevels - 1);
+}
+
+const HeatmapTiles::Options& HeatmapTiles::options() const {
+    return m_options;
+}
+
+void HeatmapTiles::add(const QPointF& pos, qint64 dwellMs, qint64 nowMs) {
+    const double fx = pos.x() - m_options.area.left();
+    const double fy = pos.y() - m_options.area.top();
+    if (dwellMs <= 0 || !(fx >= 0 && fy >= 0 && fx < m_options.area.width() &&
+                          fy < m_options.area.height())) {
+        return;
+    }
+    if (nowMs - m_liveEpoch > kMaxLiveExponent * m_liveTauMs) {
+        rescaleLive(nowMs);
+    }
+    const auto live = static_cast<float>(dwellMs / 1000.0 *
+                                         std::exp((nowMs - m_liveEpoch) / m_liveTauMs));
+    for (int level = 0; level < kLevels; ++level) {
+        const double cell = m_levels[level].cell;
+        const auto cx = static_cast<int>(fx / cell);
+        const auto cy = static_cast<int>(fy / cell);
+        Tile* t = tile(level, cx / kTileSide, cy / kTileSide, nowMs);
+        const int i = (cy % kTileSide) * kTileSide + cx % kTileSide;
+        t->history[i] += static_cast<quint64>(dwellMs);
+        t->live[i] += live;
+    }
+}
+
+double HeatmapTiles::cellSize(int level) const {
+    return m_levels[std::clamp(level, 0, kLevels - 1)].cell;
+}
+
+int HeatmapTiles::levelFor(double minCell) const {
+    for (int level = 0; level < kLevels; ++level) {
+        if (m_levels[level].cell >= minCell) {
+            return level;
+        }
+    }
+    return kLevels - 1;
+}
+
+QSize HeatmapTiles::imageSize(int level) const {
+    const QRect bounds = tileBounds(level);
+    return bounds.isEmpty() ? QSize() : bounds.size() * kTileSide;
+}
+
+QImage HeatmapTiles::render(Layer layer, int level, qint64 nowMs, QRectF* area) const {
+    level = std::clamp(level, 0, kLevels - 1);
+    const Level& l = m_levels[level];
+    const QRect bounds = tileBounds(level);
+    if (bounds.isEmpty()) {
+        *area = QRectF();
+        return {};
+    }
+
+    double scale;
+    double norm;
+    if (layer == Layer::HISTORY) {
+        quint64 top = 0;
+        for (const auto& [key, tile] : l.tiles) {
+            top = std::max(top, *std::max_element(tile->history.begin(), tile->history.end()));
+        }
+        scale = 1.0 / 1000.0;
+        norm = std::log1p(top * scale);
+    } else {
+        // метка, стоящая на месте, в пределе набирает tau секунд
+        scale = std::exp(-(nowMs - m_liveEpoch) / m_liveTauMs);
+        norm = std::log1p(m_liveTauMs / 1000.0);
+    }
+    if (norm <= 0) {
+        norm = 1;
+    }
+
+    const int width = bounds.width() * kTileSide;
+    const int height = bounds.height() * kTileSide;
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    const auto& colors = palette();
+    for (const auto& [key, tile] : l.tiles) {
+        const int tx = static_cast<int>(key % l.tilesX) - bounds.left();
+        const int ty = static_cast<int>(key / l.tilesX) - bounds.top();
+        for (int row = 0; row < kTileSide; ++row) {
+            // строки картинки идут сверху вниз, то есть по убыванию y
+            auto* line = reinterpret_cast<QRgb*>(
+                             image.scanLine(height - 1 - (ty * kTileSide + row))) +
+                         tx * kTileSide;
+            for (int column = 0; column < kTileSide; ++column) {
+                const int i = row * kTileSide + column;
+                const double value = layer == Layer::HISTORY ? tile->history[i] * scale
+                                                             : tile->live[i] * scale;
+                if (value <= 0) {
+                    continue;
+                }
+                const int index =
+                    std::min(255, static_cast<int>(std::log1p(value) / norm * 255));
+                if (index > 0) {
+                    line[column] = colors[index];
+                }
+            }
+        }
+    }
+
+    const double tileSize = l.cell * kTileSide;
+    *area = QRectF(m_options.area.left() + bounds.left() * tileSize,
+                   m_options.area.top() + bounds.top() * tileSize, width * l.cell,
+                   height * l.cell);
+    return image;
+}
+
+bool HeatmapTiles::isEmpty() const {
+    return m_tileCount == 0;
+}
+
+qsizetype HeatmapTiles::tileCount() const {
+    return m_tileCount;
+}
+
+qsizetype HeatmapTiles::memoryBytes() const {
+    return m_tileCount * static_cast<qsizetype>(sizeof(Tile));
+}
+
+qint64 HeatmapTiles::evicted() const {
+    return m_evicted;
+}
+
+void HeatmapTiles::clear() {
+    for (auto& l : m_levels) {
+        l.tiles.clear();
+    }
+    m_tileCount = 0;
+}
+
+bool HeatmapTiles::save(QIODevice* device) const {
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kVersion << m_options.area << m_options.cellSize << qint32(kLevels)
+        << qint32(kTileSide) << qint64(m_tileCount);
+    for (int level = 0; level < kLevels; ++level) {
+        for (const auto& [key, tile] : m_levels[level].tiles) {
+            out << qint32(level) << key;
+            for (const quint64 value : tile->history) {
+                out << value;
+            }
+        }
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool HeatmapTiles::load(QIODevice* device) {
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    qint32 version = 0;
+    QRectF area;
+    double cellSize = 0;
+    qint32 levels = 0;
+    qint32 side = 0;
+    qint64 count = 0;
+    in >> magic >> version >> area >> cellSize >> levels >> side >> count;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kVersion ||
+        area != m_options.area || cellSize != m_options.cellSize || levels != kLevels ||
+        side != kTileSide || count < 0) {
+        return false;
+    }
+
+    clear();
+    for (qint64 n = 0; n < count; ++n) {
+        qint32 level = -1;
+        quint32 key = 0;
+        in >> level >> key;
+        if (in.status() != QDataStream::Ok || level < 0 || level >= kLevels ||
+            key >= quint32(m_levels[level].tilesX) * quint32(m_levels[level].tilesY)) {
+            clear();
+            return false;
+        }
+        const int tilesX = m_levels[level].tilesX;
+        Tile* t = tile(level, static_cast<int>(key % tilesX), static_cast<int>(key / tilesX), 0);
+        for (quint64& value : t->history) {
+            in >> value;
+        }
+    }
+    if (in.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+HeatmapTiles::Tile* HeatmapTiles::tile(int level, int tx, int ty, qint64 nowMs) {
+    Level& l = m_levels[level];
+    const auto key = static_cast<quint32>(ty * l.tilesX + tx);
+    auto it = l.tiles.find(key);
+    if (it == l.tiles.end()) {
+        if (m_tileCount >= m_options.maxTiles) {
+            evictOne();
+        }
+        it = l.tiles.emplace(key, std::make_unique<Tile>()).first;
+        ++m_tileCount;
+    }
+    it->second->touched = nowMs;
+    return it->second.get();
+}
+
+void HeatmapTiles::evictOne() {
+    // самый грубый уровень не трогаем: по нему видна вся история
+    for (int level = 0; level < kLevels - 1; ++level) {
+        auto& tiles = m_levels[level].tiles;
+        if (tiles.empty()) {
+            continue;
+        }
+        const auto oldest = std::min_element(
+            tiles.begin(), tiles.end(),
+            [](const auto& a, const auto& b) { return a.second->touched < b.second->touched; });
+        tiles.erase(oldest);
+        --m_tileCount;
+        ++m_evicted;
+        return;
+    }
+}
+
+void HeatmapTiles::rescaleLive(qint64 nowMs) {
+    const auto factor = static_cast<float>(std::exp(-(nowMs - m_liveEpoch) / m_liveTauMs));
+    for (auto& l : m_levels) {
+        for (auto& [key, tile] : l.tiles) {
+            for (float& value : tile->live) {
+                value *= factor;
+            }
+        }
+    }
+    m_liveEpoch = nowMs;
+}
+
+QRect HeatmapTiles::tileBounds(int level) const {
+    const Level& l = m_levels[std::clamp(level, 0, kLevels - 1)];
+    if (l.tiles.empty()) {
+        return {};
+    }
+    int minX = l.tilesX;
+    int minY = l.tilesY;
+    int maxX = -1;
+    int maxY = -1;
+    for (const auto& [key, tile] : l.tiles) {
+        const int tx = static_cast<int>(key % l.tilesX);
+        const int ty = static_cast<int>(key / l.tilesX);
+        minX = std::min(minX, tx);
+        minY = std::min(minY, ty);
+        maxX = std::max(maxX, tx);
+        maxY = std::max(maxY, ty);
+    }
+    return QRect(QPoint(minX, minY), QPoint(maxX, maxY));
+}
+
+Heatmap::Heatmap(const HeatmapTiles::Options& options, QObject* parent)
+    : QObject(parent), m_tiles(options), m_timer(new QTimer(this)) {
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(kRenderIntervalMsec);
+    connect(m_timer, &QTimer::timeout, this, &Heatmap::render);
+    m_clock.start();
+}
+
+Heatmap::~Heatmap() {
+    save();
+}
+
+void Heatmap::setMetrics(metrics::Registry& registry) {
+    m_tilesGauge = &registry.gauge("bacon_heatmap_tiles", "Allocated heatmap tiles");
+    m_bytesGauge = &registry.gauge("bacon_heatmap_bytes", "Memory held by heatmap tiles");
+    m_evictedCounter = &registry.counter("bacon_heatmap_tiles_evicted_total",
+                                         "Heatmap tiles evicted by the tile budget");
+}
+
+void Heatmap::addPositions(const QList<TagPosition>& positions) {
+    const qint64 now = m_clock.elapsed();
+    for (const auto& p : positions) {
+        const auto it = m_lastSeen.find(p.tag);
+        if (it == m_lastSeen.end()) {
+            m_lastSeen.insert(p.tag, {p.pos, now});
+            continue;
+        }
+        const qint64 gap = now - it->time;
+        if (gap <= kMaxGapMsec) {
+            m_tiles.add(it->pos, gap, now);
+        }
+        *it = {p.pos, now};
+    }
+    m_addedAt = now;
+    schedule();
+}
+
+void Heatmap::setLayer(HeatmapTiles::Layer layer) {
+    m_layer = layer;
+    schedule();
+}
+
+void Heatmap::setRendering(bool enabled) {
+    m_rendering = enabled;
+    schedule();
+}
+
+void Heatmap::setPixelsPerMeter(double pixelsPerMeter) {
+    if (pixelsPerMeter > 0) {
+        m_pixelsPerMeter = pixelsPerMeter;
+        schedule();
+    }
+}
+
+void Heatmap::setFile(const QString& path) {
+    m_file = path;
+    m_savedAt = m_clock.elapsed();
+    if (m_file.isEmpty()) {
+        return;
+    }
+    QFile file(m_file);
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly) || !m_tiles.load(&file)) {
+            BACON_LOG_WARN("heatmap", "cannot load history", "file", m_file.toStdString());
+        }
+    }
+    schedule();
+}
+
+void Heatmap::save() {
+    if (m_file.isEmpty()) {
+        return;
+    }
+    m_savedAt = m_clock.elapsed();
+    // пишем во временный файл: при сбое остаётся прошлая история
+    QSaveFile file(m_file);
+    if (!file.open(QIODevice::WriteOnly) || !m_tiles.save(&file) || !file.commit()) {
+        BACON_LOG_WARN("heatmap", "cannot save history", "file", m_file.toStdString());
+    }
+}
+
+void Heatmap::clear() {
+    m_tiles.clear();
+    m_lastSeen.clear();
+    schedule();
+}
+
+void Heatmap::schedule() {
+    // таймер тикает и при выключенной отрисовке: метрики и сохранение
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void Heatmap::render() {
+    const qint64 now = m_clock.elapsed();
+    // пропавшие метки больше ничего не добавят
+    for (auto it = m_lastSeen.begin(); it != m_lastSeen.end();) {
+        if (now - it->time > kMaxGapMsec) {
+            it = m_lastSeen.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_tilesGauge) {
+        m_tilesGauge->set(m_tiles.tileCount());
+        m_bytesGauge->set(m_tiles.memoryBytes());
+        m_evictedCounter->add(static_cast<quint64>(m_tiles.evicted() - m_evictedReported));
+        m_evictedReported = m_tiles.evicted();
+    }
+    if (!m_file.isEmpty() && now - m_savedAt >= kSaveIntervalMsec) {
+        save();
+    }
+    if (!m_rendering) {
+        return;
+    }
+
+    // уровень по масштабу, но картинка не больше kMaxImageSide
+    int level = m_tiles.levelFor(kMinCellPixels / m_pixelsPerMeter);
+    for (; level < HeatmapTiles::kLevels - 1; ++level) {
+        const QSize size = m_tiles.imageSize(level);
+        if (size.width() <= kMaxImageSide && size.height() <= kMaxImageSide) {
+            break;
+        }
+    }
+    QRectF area;
+    const QImage image = m_tiles.render(m_layer, level, now, &area);
+    emit imageReady(image, area);
+
+    // живой слой тускнеет и без новых позиций, пока не погаснет
+    const double fadeMs = 8 * m_tiles.options().liveHalfLife * 1000.0;
+    if (m_layer == HeatmapTiles::Layer::LIVE && !m_tiles.isEmpty() && now - m_addedAt < fadeMs) {
+        schedule();
+    }
+}
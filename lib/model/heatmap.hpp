@@ -0,0 +1,224 @@
+#ifndef APP_HEATMAP_HPP
+#define APP_HEATMAP_HPP
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QIODevice>
+#include <QObject>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QString>
+#include <QTimer>
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+
+#include "metrics/metrics.h"
+#include "positionbatcher.hpp"
+
+/**
+ * Накопитель времени пребывания меток по ячейкам пола.
+ * Пирамида из kLevels уровней: ячейка уровня L в 2^L раз крупнее базовой,
+ * каждая позиция пополняет по одной ячейке на каждом уровне. Уровни разбиты
+ * на плитки kTileSide x kTileSide ячеек, плитка заводится при первом
+ * попадании в неё. Плиток не больше maxTiles: при нехватке вытесняется
+ * дольше всех не обновлявшаяся плитка самого мелкого непустого уровня,
+ * самый грубый уровень не вытесняется и хранит всю историю.
+ * История - целые миллисекунды, за годы не теряет точности; живой слой
+ * забывается экспоненциально, множитель забывания применяется лениво.
+ */
+class HeatmapTiles {
+public:
+    static constexpr int kLevels = 5;
+    static constexpr int kTileSide = 64;
+    static constexpr int kTileCells = kTileSide * kTileSide;
+
+    enum class Layer { HISTORY, LIVE };
+
+    struct Options {
+        QRectF area{-100, -100, 200, 200};  // покрываемая область, м
+        double cellSize = 0.25;             // ячейка уровня 0, м
+        qsizetype maxTiles = 256;
+        double liveHalfLife = 300;          // с
+    };
+
+    explicit HeatmapTiles(const Options& options = {});
+
+    [[nodiscard]] const Options& options() const;
+
+    /**
+     * Добавляет к ячейке точки время пребывания на всех уровнях.
+     * Точки вне области не учитываются.
+     * @param nowMs монотонное время, не убывает от вызова к вызову
+     */
+    void add(const QPointF& pos, qint64 dwellMs, qint64 nowMs);
+
+    [[nodiscard]] double cellSize(int level) const;
+
+    /**
+     * Самый мелкий уровень с ячейкой не меньше minCell м (или самый грубый)
+     */
+    [[nodiscard]] int levelFor(double minCell) const;
+
+    /**
+     * Размер картинки уровня в пикселях: рамка его плиток
+     */
+    [[nodiscard]] QSize imageSize(int level) const;
+
+    /**
+     * Слой уровня картинкой: пиксель - ячейка, строка 0 - наибольший y.
+     * История нормируется по самой занятой ячейке, живой слой - по ячейке,
+     * где одна метка стоит непрерывно. Шкала логарифмическая.
+     * @param area сюда записывается охваченная картинкой область, м
+     * @return Пустая картинка, если на уровне нет плиток
+     */
+    [[nodiscard]] QImage render(Layer layer, int level, qint64 nowMs, QRectF* area) const;
+
+    [[nodiscard]] bool isEmpty() const;
+
+    [[nodiscard]] qsizetype tileCount() const;
+
+    [[nodiscard]] qsizetype memoryBytes() const;
+
+    /**
+     * Сколько плиток вытеснено из-за ограничения maxTiles
+     */
+    [[nodiscard]] qint64 evicted() const;
+
+    void clear();
+
+    /**
+     * Сохраняет историю (живой слой не сохраняется)
+     */
+    bool save(QIODevice* device) const;
+
+    /**
+     * Загружает историю, сохранённую с той же областью и ячейкой
+     */
+    bool load(QIODevice* device);
+
+private:
+    struct Tile {
+        std::array<quint64, kTileCells> history{};  // мс
+        std::array<float, kTileCells> live{};       // с, без множителя забывания
+        qint64 touched = 0;
+    };
+
+    struct Level {
+        double cell = 0;
+        int tilesX = 0;
+        int tilesY = 0;
+        std::unordered_map<quint32, std::unique_ptr<Tile>> tiles;  // ty * tilesX + tx
+    };
+
+    Options m_options;
+    std::array<Level, kLevels> m_levels;
+    qsizetype m_tileCount = 0;
+    qint64 m_evicted = 0;
+
+    // текущее значение живого слоя: live * exp(-(now - m_liveEpoch) / m_liveTauMs)
+    double m_liveTauMs;
+    qint64 m_liveEpoch = 0;
+
+    Tile* tile(int level, int tx, int ty, qint64 nowMs);
+
+    // рамка заведённых плиток уровня, в плитках
+    QRect tileBounds(int level) const;
+
+    void evictOne();
+
+    void rescaleLive(qint64 nowMs);
+};
+
+/**
+ * Тепловая карта в своём потоке: копит позиции из Model::tagsMoved и не
+ * чаще kRenderIntervalMsec отдаёт готовую картинку уровня, подходящего
+ * масштабу сцены. Время пребывания метки - промежуток до её следующей
+ * позиции, он засчитывается в ячейку предыдущей.
+ * Если задан файл, история загружается из него, сохраняется раз в
+ * kSaveIntervalMsec и при удалении объекта.
+ */
+class Heatmap : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kRenderIntervalMsec = 500;
+    // дольше без позиций - метка не стояла, а пропадала; такой промежуток не засчитывается
+    static constexpr qint64 kMaxGapMsec = 5000;
+    static constexpr qint64 kSaveIntervalMsec = 10 * 60 * 1000;
+    static constexpr int kMaxImageSide = 2048;
+    // ячейка уровня на экране не мельче стольких пикселей
+    static constexpr double kMinCellPixels = 3.0;
+
+    explicit Heatmap(const HeatmapTiles::Options& options = {},
+                     QObject* parent = nullptr);
+
+    ~Heatmap() override;
+
+    /**
+     * Публикует число плиток, их память и вытеснения.
+     * Вызывается до переноса в поток, реестр должен пережить карту
+     */
+    void setMetrics(metrics::Registry& registry);
+
+signals:
+    /**
+     * @param area область картинки, м
+     */
+    void imageReady(const QImage& image, const QRectF& area);
+
+public slots:
+    void addPositions(const QList<TagPosition>& positions);
+
+    void setLayer(HeatmapTiles::Layer layer);
+
+    /**
+     * Пока выключено, позиции копятся, но картинки не строятся
+     */
+    void setRendering(bool enabled);
+
+    void setPixelsPerMeter(double pixelsPerMeter);
+
+    /**
+     * Файл истории; существующий загружается, пустая строка - не сохранять
+     */
+    void setFile(const QString& path);
+
+    void save();
+
+    void clear();
+
+private:
+    struct Seen {
+        QPointF pos;
+        qint64 time;
+    };
+
+    HeatmapTiles m_tiles;
+    QElapsedTimer m_clock;
+    QHash<QString, Seen> m_lastSeen;
+    QTimer* m_timer;
+
+    HeatmapTiles::Layer m_layer = HeatmapTiles::Layer::HISTORY;
+    bool m_rendering = false;
+    double m_pixelsPerMeter = 30.0;
+
+    qint64 m_addedAt = 0;
+
+    QString m_file;
+    qint64 m_savedAt = 0;
+
+    metrics::Gauge* m_tilesGauge = nullptr;
+    metrics::Gauge* m_bytesGauge = nullptr;
+    metrics::Counter* m_evictedCounter = nullptr;
+    qint64 m_evictedReported = 0;
+
+    void schedule();
+
+    void render();
+};
+
+#endif  //APP_HEATMAP_HPP
@@ -1,9 +1,32 @@
 #include "model.hpp"
 
+#include <QDateTime>
+
 #include <iostream>
 
+#include "tracing/trace.h"
+
 Model::Model(mqtt_connector::MqttClient* connector)
-    : m_esp(QString("esp"), QPointF(10.0, 10.0)), m_connector(connector) {}
+    : m_esp(QString("esp"), QPointF(10.0, 10.0)),
+      m_connector(connector),
+      m_heatmap(new Heatmap()) {
+    tagId(QString::fromLatin1(message_objects::kDefaultTag));
+
+    // карта копит и рисует в своём потоке, удаляется (и сохраняется) в нём же
+    if (m_connector) {
+        m_heatmap->setMetrics(m_connector->metrics());
+    }
+    m_heatmapThread.setObjectName("heatmap");
+    m_heatmap->moveToThread(&m_heatmapThread);
+    connect(&m_heatmapThread, &QThread::finished, m_heatmap, &QObject::deleteLater);
+    connect(this, &Model::tagsMoved, m_heatmap, &Heatmap::addPositions);
+    m_heatmapThread.start();
+}
+
+Model::~Model() {
+    m_heatmapThread.quit();
+    m_heatmapThread.wait();
+}
 
 QList<Beacon> Model::beacons() const {
     return m_beacons;
@@ -34,16 +57,75 @@ void Model::addPointToPath(const QPointF& pos) {
         return;
     }
     QPointF p = pos;
-    m_path.append(p);
+    const auto evicted = m_path.append({p, QDateTime::currentMSecsSinceEpoch()});
+    if (evicted > 0) {
+        emit pathTrimmed(evicted);
+    }
     m_esp.setPos(p);
     emit dataChanged();
     emit pointAddedSignal(p);
 }
 
-QList<QPointF> Model::path() const {
+void Model::addPointsToPath(const QList<TagPosition>& points) {
+    if (!m_running || points.isEmpty()) {
+        return;
+    }
+    const std::uint64_t traceStart = tracing::enabled() ? tracing::now() : 0;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qsizetype evicted = 0;
+    for (const auto& p : points) {
+        evicted += m_path.append({p.pos, now, tagId(p.tag)});
+    }
+    if (traceStart) {
+        const std::uint64_t traceEnd = tracing::now();
+        for (const auto& p : points) {
+            if (p.trace) {
+                tracing::record(tracing::Stage::MODEL_APPEND, traceStart, traceEnd, p.trace);
+            }
+        }
+    }
+    if (evicted > 0) {
+        emit pathTrimmed(evicted);
+    }
+    m_esp.setPos(points.last().pos);
+    emit dataChanged();
+    emit pointsAddedSignal(points.size());
+    emit tagsMoved(points);
+}
+
+quint32 Model::tagId(const QString& tag) {
+    const auto it = m_tagIds.constFind(tag);
+    if (it != m_tagIds.constEnd()) {
+        return it.value();
+    }
+    const auto id = static_cast<quint32>(m_tagNames.size());
+    m_tagNames.append(tag);
+    m_tagIds.insert(tag, id);
+    return id;
+}
+
+QString Model::tagName(quint32 id) const {
+    return m_tagNames.value(static_cast<qsizetype>(id));
+}
+
+const PathStorage& Model::path() const {
     return m_path;
 }
 
+void Model::setPathSpillFile(const QString& filePath) {
+    m_path.setSpillFile(filePath);
+}
+
+Heatmap* Model::heatmap() const {
+    return m_heatmap;
+}
+
+void Model::setHeatmapFile(const QString& filePath) {
+    QMetaObject::invokeMethod(m_heatmap, [heatmap = m_heatmap, filePath] {
+        heatmap->setFile(filePath);
+    });
+}
+
 void Model::updateBeacon(int index, const Beacon& beacon) {
     m_beacons[index] = beacon;
     QList<QPair<QString, QPointF>> newBeacons;
@@ -79,7 +161,7 @@ void Model::pointAdded(const QPointF& point) {
     if (!m_running) {
         return;
     }
-    m_path.append(point);
+    m_path.append({point, QDateTime::currentMSecsSinceEpoch()});
     emit pathChanged();
 }
 
@@ -94,7 +176,10 @@ void Model::onUrlChanged(const QString& url) {
 }
 
 void Model::setPath(const QList<QPointF>& path) {
-    m_path = path;
+    m_path.clear();
+    for (const auto& point : path) {
+        m_path.append({point, 0});
+    }
     emit satPath();
 }
 
@@ -5,7 +5,14 @@
 
 #include "beacon.hpp"
 #include "espobject.hpp"
+#include "heatmap.hpp"
 #include "mqtt_connector/mqtt_client.h"
+#include "pathstorage.hpp"
+#include "positionbatcher.hpp"
+
+#include <QHash>
+#include <QStringList>
+#include <QThread>
 
 class Model : public QObject {
     Q_OBJECT
@@ -13,6 +20,8 @@ class Model : public QObject {
    public:
     explicit Model(mqtt_connector::MqttClient* connector);
 
+    ~Model() override;
+
     [[nodiscard]] QList<Beacon> beacons() const;
 
     [[nodiscard]] Beacon beacon(int index) const;
@@ -27,7 +36,43 @@ class Model : public QObject {
 
     void addPointToPath(const QPointF& pos);
 
-    [[nodiscard]] QList<QPointF> path() const;
+    /**
+     * Добавляет пачку позиций за один кадр:
+     * по одному dataChanged и pointsAddedSignal на всю пачку
+     */
+    void addPointsToPath(const QList<TagPosition>& points);
+
+    /**
+     * Номер устройства для PathPoint::tag, новые метки регистрируются.
+     * Метка по умолчанию (message_objects::kDefaultTag) всегда имеет номер 0.
+     */
+    quint32 tagId(const QString& tag);
+
+    [[nodiscard]] QString tagName(quint32 id) const;
+
+    /**
+     * Путь без копирования. Ссылка живёт столько же, сколько модель,
+     * итераторы и чанки - до следующего изменения пути.
+     */
+    [[nodiscard]] const PathStorage& path() const;
+
+    /**
+     * Включает сброс вытесненной части пути на диск
+     * @param filePath файл для сброса, пустая строка - выключить
+     */
+    void setPathSpillFile(const QString& filePath);
+
+    /**
+     * Тепловая карта пребывания устройств. Живёт в своём потоке,
+     * слоты вызываются через очередь
+     */
+    [[nodiscard]] Heatmap* heatmap() const;
+
+    /**
+     * Файл истории тепловой карты
+     * @param filePath пустая строка - не сохранять
+     */
+    void setHeatmapFile(const QString& filePath);
 
     void updateBeacon(int index, const Beacon& beacon);
 
@@ -38,6 +83,18 @@ class Model : public QObject {
    signals:
     void dataChanged();
     void pointAddedSignal(const QPointF& pnt);
+    void pointsAddedSignal(qsizetype count);
+
+    /**
+     * Устройства сменили позиции (пачка за кадр, в порядке поступления)
+     */
+    void tagsMoved(const QList<TagPosition>& positions);
+
+    /**
+     * Из начала пути вытеснены самые старые точки
+     * @param count сколько точек вытеснено
+     */
+    void pathTrimmed(qsizetype count);
 
     void pathChanged();
 
@@ -54,7 +111,9 @@ class Model : public QObject {
    private:
     QList<Beacon> m_beacons;
     EspObject m_esp;
-    QList<QPointF> m_path;
+    PathStorage m_path;
+    QStringList m_tagNames;
+    QHash<QString, quint32> m_tagIds;
     QString m_url;
     QString m_status = "None";
     float m_freq;
@@ -63,6 +122,9 @@ class Model : public QObject {
 
     mqtt_connector::MqttClient* m_connector;
 
+    Heatmap* m_heatmap;
+    QThread m_heatmapThread;
+
    public slots:
     void beaconChanged(const QList<Beacon>& beacons);
     void pointAdded(const QPointF& point);
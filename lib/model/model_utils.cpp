@@ -45,17 +45,37 @@ namespace model_utils {
         return result;
     }
 
+    namespace {
+        QString formatPoint(const QPointF &point) {
+            // Форматируем с точностью до 2 знаков после запятой
+            QString xStr = QString::number(point.x(), 'f', 2).replace('.', ',');
+            QString yStr = QString::number(point.y(), 'f', 2).replace('.', ',');
+            return xStr + ";" + yStr;
+        }
+    }
+
     QString fetchContent(const QList<QPointF> &points) {
         QStringList lines;
         lines.append("X;Y");
 
         for (const QPointF &point: points) {
-            // Форматируем с точностью до 2 знаков после запятой
-            QString xStr = QString::number(point.x(), 'f', 2).replace('.', ',');
-            QString yStr = QString::number(point.y(), 'f', 2).replace('.', ',');
-
-            lines.append(xStr + ";" + yStr);
+            lines.append(formatPoint(point));
         }
         return lines.join("\n");
     }
+
+    bool writeContent(QTextStream &out, const PathStorage &path) {
+        out << "X;Y";
+
+        // сброшенная часть читается с диска по чанку, целиком в память не грузится
+        const bool spilled = path.forEachSpilled([&out](std::span<const PathPoint> points) {
+            for (const PathPoint &point: points) {
+                out << '\n' << formatPoint(point.pos);
+            }
+        });
+        for (const PathPoint &point: path) {
+            out << '\n' << formatPoint(point.pos);
+        }
+        return spilled && out.status() == QTextStream::Ok;
+    }
 };
@@ -3,10 +3,15 @@
 #include <QPoint>
 #include <string>
 #include <QList>
+#include <QTextStream>
+
+#include "pathstorage.hpp"
 
 namespace model_utils {
     QList<QPointF> parseContent(const std::string &content);
     QString fetchContent(const QList<QPointF> &points);
+    // Пишет путь вместе со сброшенной на диск частью, не собирая его в памяти
+    bool writeContent(QTextStream &out, const PathStorage &path);
 
 };
 
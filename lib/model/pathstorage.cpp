@@ -0,0 +1,120 @@
+#include "pathstorage.hpp"
+
+#include <QFile>
+
+#include <algorithm>
+
+namespace {
+qsizetype roundToChunks(qsizetype capacity) {
+    // минимум два чанка, чтобы после вытеснения в памяти оставалась история
+    const qsizetype chunks =
+        std::max<qsizetype>(2, (capacity + PathStorage::kChunkSize - 1) /
+                                   PathStorage::kChunkSize);
+    return chunks * PathStorage::kChunkSize;
+}
+}  // namespace
+
+PathStorage::PathStorage(qsizetype capacity)
+    : m_capacity(roundToChunks(capacity)) {}
+
+qsizetype PathStorage::append(const PathPoint& point) {
+    qsizetype evicted = 0;
+    if (m_size % kChunkSize == 0) {
+        if (m_size == m_capacity) {
+            evictFront();
+            evicted = kChunkSize;
+        }
+        if (m_spare) {
+            m_chunks.push_back(std::move(m_spare));
+        } else {
+            m_chunks.push_back(std::make_unique<Chunk>());
+        }
+    }
+    (*m_chunks.back())[m_size % kChunkSize] = point;
+    ++m_size;
+    return evicted;
+}
+
+void PathStorage::clear() {
+    if (!m_chunks.empty() && !m_spare) {
+        m_spare = std::move(m_chunks.front());
+    }
+    m_chunks.clear();
+    m_size = 0;
+    m_evicted = 0;
+    if (!m_spillPath.isEmpty()) {
+        QFile::remove(m_spillPath);
+    }
+}
+
+std::span<const PathPoint> PathStorage::chunk(qsizetype index) const {
+    const qsizetype first = index * kChunkSize;
+    const qsizetype count = std::min(kChunkSize, m_size - first);
+    return {m_chunks[index]->data(), static_cast<std::size_t>(count)};
+}
+
+void PathStorage::setCapacity(qsizetype capacity) {
+    m_capacity = roundToChunks(capacity);
+    while (m_size > m_capacity) {
+        evictFront();
+    }
+}
+
+void PathStorage::setSpillFile(const QString& path) {
+    if (!path.isEmpty() && path != m_spillPath) {
+        QFile::remove(path);
+    }
+    m_spillPath = path;
+}
+
+bool PathStorage::forEachSpilled(
+    const std::function<void(std::span<const PathPoint>)>& visit) const {
+    if (m_spillPath.isEmpty() || !QFile::exists(m_spillPath)) {
+        return true;
+    }
+    QFile file(m_spillPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    auto buffer = std::make_unique<Chunk>();
+    while (true) {
+        const qint64 bytes = file.read(reinterpret_cast<char*>(buffer->data()),
+                                       static_cast<qint64>(sizeof(Chunk)));
+        const auto count = bytes > 0 ? static_cast<std::size_t>(bytes) / sizeof(PathPoint) : 0;
+        if (count == 0) {
+            return bytes == 0;
+        }
+        visit({buffer->data(), count});
+    }
+}
+
+QList<QPointF> PathStorage::toList() const {
+    QList<QPointF> result;
+    result.reserve(m_size);
+    for (const auto& point : *this) {
+        result.append(point.pos);
+    }
+    return result;
+}
+
+void PathStorage::evictFront() {
+    // в начале всегда лежит полный чанк: частично заполнен только последний
+    auto front = std::move(m_chunks.front());
+    m_chunks.pop_front();
+    spill(*front);
+    m_size -= kChunkSize;
+    m_evicted += kChunkSize;
+    m_spare = std::move(front);
+}
+
+void PathStorage::spill(const Chunk& chunk) const {
+    if (m_spillPath.isEmpty()) {
+        return;
+    }
+    QFile file(m_spillPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(chunk.data()),
+               static_cast<qint64>(sizeof(Chunk)));
+}
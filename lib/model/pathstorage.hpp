@@ -0,0 +1,198 @@
+#ifndef APP_PATHSTORAGE_HPP
+#define APP_PATHSTORAGE_HPP
+
+#include <QList>
+#include <QPointF>
+#include <QString>
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+/**
+ * Точка пути с меткой времени (мс с начала эпохи, 0 если неизвестно)
+ * и номером устройства (см. Model::tagId)
+ */
+struct PathPoint {
+    QPointF pos;
+    qint64 time = 0;
+    quint32 tag = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<PathPoint>);
+
+/**
+ * Хранилище пути фиксированного объёма.
+ * Точки лежат в чанках по kChunkSize штук, добавление O(1).
+ * Когда объём исчерпан, самый старый чанк вытесняется (и, если задан файл,
+ * дописывается в него), а его память переиспользуется под новые точки.
+ * Индекс 0 - самая старая точка из находящихся в памяти.
+ */
+class PathStorage {
+public:
+    static constexpr qsizetype kChunkSize = 4096;
+    static constexpr qsizetype kDefaultCapacity = 256 * kChunkSize;
+
+    using Chunk = std::array<PathPoint, kChunkSize>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = PathPoint;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const PathPoint*;
+        using reference = const PathPoint&;
+
+        const_iterator() = default;
+        const_iterator(const PathStorage* storage, qsizetype index)
+            : m_storage(storage), m_index(index) {}
+
+        reference operator*() const { return m_storage->at(m_index); }
+        pointer operator->() const { return &m_storage->at(m_index); }
+        reference operator[](difference_type n) const {
+            return m_storage->at(m_index + n);
+        }
+
+        const_iterator& operator++() {
+            ++m_index;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++m_index;
+            return tmp;
+        }
+        const_iterator& operator--() {
+            --m_index;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            auto tmp = *this;
+            --m_index;
+            return tmp;
+        }
+        const_iterator& operator+=(difference_type n) {
+            m_index += n;
+            return *this;
+        }
+        const_iterator& operator-=(difference_type n) {
+            m_index -= n;
+            return *this;
+        }
+        friend const_iterator operator+(const_iterator it, difference_type n) {
+            return it += n;
+        }
+        friend const_iterator operator+(difference_type n, const_iterator it) {
+            return it += n;
+        }
+        friend const_iterator operator-(const_iterator it, difference_type n) {
+            return it -= n;
+        }
+        friend difference_type operator-(const const_iterator& a,
+                                         const const_iterator& b) {
+            return a.m_index - b.m_index;
+        }
+        friend bool operator==(const const_iterator& a,
+                               const const_iterator& b) {
+            return a.m_index == b.m_index;
+        }
+        friend auto operator<=>(const const_iterator& a,
+                                const const_iterator& b) {
+            return a.m_index <=> b.m_index;
+        }
+
+    private:
+        const PathStorage* m_storage = nullptr;
+        qsizetype m_index = 0;
+    };
+
+    explicit PathStorage(qsizetype capacity = kDefaultCapacity);
+
+    /**
+     * Добавляет точку в конец.
+     * @return сколько старых точек было вытеснено (0 или kChunkSize)
+     */
+    qsizetype append(const PathPoint& point);
+
+    /**
+     * Удаляет все точки, память чанков остаётся для повторного использования.
+     * Файл вытеснения усекается.
+     */
+    void clear();
+
+    [[nodiscard]] qsizetype size() const { return m_size; }
+
+    [[nodiscard]] bool isEmpty() const { return m_size == 0; }
+
+    [[nodiscard]] const PathPoint& at(qsizetype index) const {
+        return (*m_chunks[index / kChunkSize])[index % kChunkSize];
+    }
+
+    [[nodiscard]] const PathPoint& last() const { return at(m_size - 1); }
+
+    [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+
+    [[nodiscard]] const_iterator end() const { return {this, m_size}; }
+
+    /**
+     * Количество чанков в памяти
+     */
+    [[nodiscard]] qsizetype chunkCount() const {
+        return static_cast<qsizetype>(m_chunks.size());
+    }
+
+    /**
+     * Непрерывный участок точек без копирования.
+     * Действителен до следующего вытеснения или clear().
+     */
+    [[nodiscard]] std::span<const PathPoint> chunk(qsizetype index) const;
+
+    /**
+     * Максимальное количество точек в памяти (кратно kChunkSize)
+     */
+    [[nodiscard]] qsizetype capacity() const { return m_capacity; }
+
+    void setCapacity(qsizetype capacity);
+
+    /**
+     * Сколько точек было вытеснено из памяти с момента clear()
+     */
+    [[nodiscard]] qint64 evictedCount() const { return m_evicted; }
+
+    /**
+     * Включает сброс вытесненных чанков на диск. Пустой путь - выключает.
+     * Оставшийся от прошлого запуска файл удаляется: в нём чужой путь.
+     */
+    void setSpillFile(const QString& path);
+
+    [[nodiscard]] QString spillFile() const { return m_spillPath; }
+
+    /**
+     * Обходит точки, сброшенные на диск (от старых к новым), по одному
+     * чанку за раз: в памяти не больше одного чанка
+     * @param visit вызывается для каждого прочитанного участка
+     * @return false, если файл задан, но не читается
+     */
+    bool forEachSpilled(const std::function<void(std::span<const PathPoint>)>& visit) const;
+
+    [[nodiscard]] QList<QPointF> toList() const;
+
+private:
+    std::deque<std::unique_ptr<Chunk>> m_chunks;
+    std::unique_ptr<Chunk> m_spare;
+    qsizetype m_size = 0;
+    qsizetype m_capacity;
+    qint64 m_evicted = 0;
+    QString m_spillPath;
+
+    void evictFront();
+
+    void spill(const Chunk& chunk) const;
+};
+
+#endif  //APP_PATHSTORAGE_HPP
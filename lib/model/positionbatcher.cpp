@@ -0,0 +1,106 @@
+#include "positionbatcher.hpp"
+
+#include <QGuiApplication>
+#include <QMutexLocker>
+#include <QScreen>
+
+#include <algorithm>
+#include <cmath>
+
+#include "tracing/trace.h"
+
+PositionBatcher::PositionBatcher(QObject* parent)
+    : QObject(parent), m_timer(new QTimer(this)) {
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+
+    int msec = 16;
+    if (const auto* screen = QGuiApplication::primaryScreen()) {
+        const qreal rate = screen->refreshRate();
+        if (rate > 0) {
+            msec = std::max(1, static_cast<int>(std::lround(1000.0 / rate)));
+        }
+    }
+    m_timer->setInterval(msec);
+
+    connect(m_timer, &QTimer::timeout, this, &PositionBatcher::flush);
+}
+
+void PositionBatcher::push(const QString& tag, const QPointF& pos) {
+    bool first;
+    {
+        QMutexLocker lock(&m_mutex);
+        first = m_pending.isEmpty();
+        if (m_pending.size() >= m_maxPending) {
+            m_pending.removeFirst();
+            ++m_dropped;
+            if (m_droppedCounter) {
+                m_droppedCounter->add();
+            }
+        }
+        m_pending.append({tag, pos, tracing::currentId()});
+        if (m_backlogGauge) {
+            m_backlogGauge->set(m_pending.size());
+        }
+    }
+    // таймер живёт в потоке батчера, запускаем его только первой позицией кадра
+    if (first) {
+        QMetaObject::invokeMethod(this, &PositionBatcher::schedule,
+                                  Qt::QueuedConnection);
+    }
+}
+
+void PositionBatcher::setInterval(int msec) {
+    m_timer->setInterval(std::max(1, msec));
+}
+
+int PositionBatcher::interval() const {
+    return m_timer->interval();
+}
+
+void PositionBatcher::setMaxPending(qsizetype maxPending) {
+    QMutexLocker lock(&m_mutex);
+    m_maxPending = std::max<qsizetype>(1, maxPending);
+}
+
+qsizetype PositionBatcher::pending() const {
+    QMutexLocker lock(&m_mutex);
+    return m_pending.size();
+}
+
+qint64 PositionBatcher::dropped() const {
+    QMutexLocker lock(&m_mutex);
+    return m_dropped;
+}
+
+void PositionBatcher::setMetrics(metrics::Registry& registry) {
+    auto& backlog = registry.gauge("bacon_gui_backlog",
+                                   "Positions waiting for delivery to the GUI");
+    auto& dropped = registry.counter("bacon_gui_dropped_total",
+                                     "Positions dropped by the GUI batcher");
+    QMutexLocker lock(&m_mutex);
+    m_backlogGauge = &backlog;
+    m_droppedCounter = &dropped;
+    m_backlogGauge->set(m_pending.size());
+}
+
+void PositionBatcher::flush() {
+    QList<TagPosition> batch;
+    {
+        QMutexLocker lock(&m_mutex);
+        batch.swap(m_pending);
+        m_pending.reserve(batch.size());
+        if (m_backlogGauge) {
+            m_backlogGauge->set(0);
+        }
+    }
+    if (!batch.isEmpty()) {
+        emit batchReady(batch);
+    }
+}
+
+void PositionBatcher::schedule() {
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef APP_POSITIONBATCHER_HPP
+#define APP_POSITIONBATCHER_HPP
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointF>
+#include <QString>
+#include <QTimer>
+
+#include "metrics/metrics.h"
+
+/**
+ * Позиция конкретного устройства
+ */
+struct TagPosition {
+    QString tag;
+    QPointF pos;
+    quint64 trace = 0;  // id позиции в трассировке, 0 - не трассируется
+};
+
+/**
+ * Мост между потоком коннектора и GUI.
+ * push() копит позиции под коротким мьютексом в любом потоке,
+ * а в потоке батчера раз в кадр уходит один batchReady со всем накопленным.
+ * Пока данных нет, таймер не тикает.
+ */
+class PositionBatcher : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr qsizetype kDefaultMaxPending = 1 << 16;
+
+    explicit PositionBatcher(QObject* parent = nullptr);
+
+    /**
+     * Потокобезопасное добавление позиции в текущий кадр.
+     * Если накоплено больше maxPending, самые старые позиции отбрасываются.
+     */
+    void push(const QString& tag, const QPointF& pos);
+
+    /**
+     * Период доставки, по умолчанию - частота обновления основного экрана
+     */
+    void setInterval(int msec);
+
+    [[nodiscard]] int interval() const;
+
+    void setMaxPending(qsizetype maxPending);
+
+    /**
+     * Сколько позиций ждёт доставки
+     */
+    [[nodiscard]] qsizetype pending() const;
+
+    /**
+     * Сколько позиций отброшено из-за переполнения
+     */
+    [[nodiscard]] qint64 dropped() const;
+
+    /**
+     * Публикует очередь доставки и отброшенные позиции в реестр метрик.
+     * Реестр должен пережить батчер
+     */
+    void setMetrics(metrics::Registry& registry);
+
+   signals:
+    void batchReady(const QList<TagPosition>& batch);
+
+   public slots:
+    /**
+     * Немедленно отдаёт накопленное
+     */
+    void flush();
+
+   private:
+    QTimer* m_timer;
+    mutable QMutex m_mutex;
+    QList<TagPosition> m_pending;
+    qsizetype m_maxPending = kDefaultMaxPending;
+    qint64 m_dropped = 0;
+    metrics::Gauge* m_backlogGauge = nullptr;
+    metrics::Counter* m_droppedCounter = nullptr;
+
+    void schedule();
+};
+
+#endif  //APP_POSITIONBATCHER_HPP
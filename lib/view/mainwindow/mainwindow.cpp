@@ -1,6 +1,8 @@
 #include "mainwindow.hpp"
 
 #include <QFileDialog>
+#include <QMessageBox>
+#include <QSaveFile>
 
 #include "ui_mainwindow.h"
 
@@ -35,8 +37,14 @@ MainWindow::MainWindow(Model* model, QWidget* parent)
             &Model::onUrlChanged);
 
     connect(m_model, &Model::dataChanged, m_scene, &Scene::espChanged);
+    connect(m_model, &Model::tagsMoved, m_scene, &Scene::onTagsMoved);
+    connect(m_model, &Model::pathTrimmed, m_pathController,
+            &PathController::trimPath);
     connect(m_model, &Model::pointAddedSignal, m_pathController,
             &PathController::addPathPoint);
+    connect(m_model, &Model::pointsAddedSignal, m_pathController,
+            &PathController::addPathPoints);
+    connect(m_model, &Model::pathTrimmed, m_scene, &Scene::onPathTrimmed);
 
     setWindowIcon(QIcon(":/assets/assets/icon.png"));
     m_ui->actionOpen_beacon->setIcon(QIcon(":/assets/assets/open.png"));
@@ -64,6 +72,9 @@ MainWindow::MainWindow(Model* model, QWidget* parent)
     connect(m_model, &Model::satPath, m_scene,
             &Scene::onPathSeted);
 
+    connect(m_model, &Model::satPath, m_pathController,
+            &PathController::setPath);
+
     connect(m_pathController, &PathController::pathReseted, m_model,
             &Model::onResetPath);
 
@@ -97,14 +108,22 @@ void MainWindow::savePathFile() {
     QString filePath =
         QFileDialog::getSaveFileName(nullptr, QObject::tr("Save Text File"), "",
                                      "Text Files (*.txt);;All Files (*)");
-    QFile file(filePath);
+    if (filePath.isEmpty()) {
+        return;
+    }
+    // QSaveFile: при ошибке (в том числе чтения сброшенной на диск части
+    // пути) прежний файл остаётся, обрезанный не появляется
+    QSaveFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         return;
     }
     QTextStream out(&file);
     out.setEncoding(QStringConverter::Utf8);
-    const auto path = m_model->path();
-    const auto content = model_utils::fetchContent(path);
-    out << content;
-    file.close();
+    const bool written = model_utils::writeContent(out, m_model->path());
+    out.flush();
+    if (!written || out.status() != QTextStream::Ok || !file.commit()) {
+        file.cancelWriting();
+        QMessageBox::warning(this, QObject::tr("Save Text File"),
+                             QObject::tr("Path was not saved to %1").arg(filePath));
+    }
 }
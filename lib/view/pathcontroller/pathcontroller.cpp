@@ -10,13 +10,16 @@ PathController::PathController(Model* model, QWidget* parent)
     : QWidget(parent),
       m_ui(new Ui::PathController),
       m_model(model),
-      m_list(new QStandardItemModel(0, 3, this)) {
+      m_list(new PathTableModel(model, this)) {
     m_ui->setupUi(this);
-    m_list->setHeaderData(0, Qt::Horizontal, "X");
-    m_list->setHeaderData(1, Qt::Horizontal, "Y");
-    m_list->setHeaderData(2, Qt::Horizontal, "Time");
     m_ui->tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
     m_ui->tableView->setModel(m_list);
+    m_ui->tableView->horizontalHeader()->setSectionResizeMode(
+        QHeaderView::Stretch);
+    // ResizeToContents обходит все строки, для длинного пути - только Fixed
+    m_ui->tableView->verticalHeader()->setSectionResizeMode(
+        QHeaderView::Fixed);
+    m_ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
 
     m_ui->resetBtn->setIcon(QIcon(":/assets/assets/stop.png"));
     m_ui->startBtn->setIcon(QIcon(":/assets/assets/play.png"));
@@ -71,33 +74,24 @@ PathController::~PathController() {
 }
 
 void PathController::setPath() {
-    const auto path = m_model->path();
-    const auto size = path.size();
-    m_list->setRowCount(size);
-    for (int row = 0; row < path.size(); ++row) {
-        const QPointF &p = path[row];
-        m_list->setItem(size - row - 1, 0, new QStandardItem(QString::number(p.x())));
-        m_list->setItem(size - row - 1, 1, new QStandardItem(QString::number(p.y())));
-    }
-
-    m_ui->tableView->horizontalHeader()->setSectionResizeMode(
-        QHeaderView::Stretch);
-    m_ui->tableView->verticalHeader()->setSectionResizeMode(
-        QHeaderView::ResizeToContents);
-    m_ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_list->reload();
 }
 
 void PathController::resetPath() {
-    m_list->removeRows(0, m_list->rowCount());
     emit pathReseted();
 }
 
 void PathController::addPathPoint(const QPointF& pnt) {
-    m_list->insertRow(0);
-    m_list->setItem(0, 0, new QStandardItem(QString::number(pnt.x())));
-    m_list->setItem(0, 1, new QStandardItem(QString::number(pnt.y())));
-    m_list->setItem(0, 2,
-                    new QStandardItem(QString::fromStdString(currentTime())));
+    Q_UNUSED(pnt);
+    m_list->onAppended();
+}
+
+void PathController::addPathPoints(qsizetype count) {
+    m_list->onAppended(count);
+}
+
+void PathController::trimPath(qsizetype count) {
+    m_list->onTrimmed(count);
 }
 
 void PathController::onUrlAccepted() {
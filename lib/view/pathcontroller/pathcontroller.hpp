@@ -5,10 +5,10 @@
 #include <QHeaderView>
 #include <QList>
 #include <QPoint>
-#include <QStandardItemModel>
 #include <QWidget>
 
 #include "model.hpp"
+#include "pathtablemodel.hpp"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -26,12 +26,14 @@ class PathController : public QWidget {
     Ui::PathController* m_ui;
     Model* m_model;
 
-    QStandardItemModel* m_list;
+    PathTableModel* m_list;
 
    public slots:
     void setPath();
     void resetPath();
     void addPathPoint(const QPointF& pnt);
+    void addPathPoints(qsizetype count);
+    void trimPath(qsizetype count);
     void onUrlAccepted();
     void onFreqAccepted();
    signals:
@@ -0,0 +1,97 @@
+#include "pathtablemodel.hpp"
+
+#include <algorithm>
+
+#include "utils.hpp"
+
+PathTableModel::PathTableModel(const Model* model, QObject* parent)
+    : QAbstractTableModel(parent),
+      m_model(model),
+      m_path(&model->path()),
+      m_rows(static_cast<int>(m_path->size())) {}
+
+int PathTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_rows;
+}
+
+int PathTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 4;
+}
+
+QVariant PathTableModel::data(const QModelIndex& index, int role) const {
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= m_rows) {
+        return {};
+    }
+    const qsizetype pos = m_path->size() - 1 - index.row();
+    if (pos < 0) {
+        return {};
+    }
+    const PathPoint& point = m_path->at(pos);
+    switch (index.column()) {
+        case 0:
+            return QString::number(point.pos.x());
+        case 1:
+            return QString::number(point.pos.y());
+        case 2:
+            if (point.time == 0) {
+                return {};
+            }
+            return QString::fromStdString(formatTime(point.time));
+        case 3:
+            return m_model->tagName(point.tag);
+        default:
+            return {};
+    }
+}
+
+QVariant PathTableModel::headerData(int section, Qt::Orientation orientation,
+                                    int role) const {
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+    switch (section) {
+        case 0:
+            return QStringLiteral("X");
+        case 1:
+            return QStringLiteral("Y");
+        case 2:
+            return QStringLiteral("Time");
+        case 3:
+            return QStringLiteral("Tag");
+        default:
+            return {};
+    }
+}
+
+void PathTableModel::onAppended(qsizetype count) {
+    const int rows = static_cast<int>(m_path->size());
+    count = std::min<qsizetype>(count, rows - m_rows);
+    if (count <= 0) {
+        return;
+    }
+    // новые точки показываются сверху
+    beginInsertRows(QModelIndex(), 0, static_cast<int>(count) - 1);
+    m_rows += static_cast<int>(count);
+    endInsertRows();
+}
+
+void PathTableModel::onTrimmed(qsizetype count) {
+    count = std::min<qsizetype>(count, m_rows);
+    if (count <= 0) {
+        return;
+    }
+    // старые точки - в самом низу таблицы
+    beginRemoveRows(QModelIndex(), m_rows - static_cast<int>(count),
+                    m_rows - 1);
+    m_rows -= static_cast<int>(count);
+    endRemoveRows();
+}
+
+void PathTableModel::reload() {
+    beginResetModel();
+    m_rows = static_cast<int>(m_path->size());
+    endResetModel();
+}
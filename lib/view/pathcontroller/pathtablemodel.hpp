@@ -0,0 +1,53 @@
+#ifndef APP_PATHTABLEMODEL_HPP
+#define APP_PATHTABLEMODEL_HPP
+
+#include <QAbstractTableModel>
+
+#include "model.hpp"
+
+/**
+ * Табличное представление пути поверх PathStorage без копирования точек.
+ * Строка 0 - самая новая точка, ячейки формируются только при отрисовке.
+ */
+class PathTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+   public:
+    explicit PathTableModel(const Model* model, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex& index,
+                  int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+   public slots:
+    /**
+     * В хранилище добавлены точки
+     * @param count сколько новых точек
+     */
+    void onAppended(qsizetype count = 1);
+
+    /**
+     * Из хранилища вытеснены самые старые точки
+     * @param count сколько точек вытеснено
+     */
+    void onTrimmed(qsizetype count);
+
+    /**
+     * Хранилище изменилось целиком
+     */
+    void reload();
+
+   private:
+    const Model* m_model;
+    const PathStorage* m_path;
+    // Количество строк, о котором уже знает представление
+    int m_rows = 0;
+};
+
+#endif  //APP_PATHTABLEMODEL_HPP
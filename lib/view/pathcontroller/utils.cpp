@@ -17,10 +17,18 @@ std::string currentTime() {
 
     // Получаем текущее время
     auto now = system_clock::now();
-    auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+    return formatTime(
+        duration_cast<milliseconds>(now.time_since_epoch()).count());
+}
+
+std::string formatTime(qint64 msecs) {
+    using namespace std::chrono;
+
+    const system_clock::time_point tp{milliseconds(msecs)};
+    auto ms = milliseconds(msecs) % 1000;
 
     // Конвертируем в локальное время
-    std::time_t t = system_clock::to_time_t(now);
+    std::time_t t = system_clock::to_time_t(tp);
     std::tm tm = *std::localtime(&t);
 
     std::ostringstream oss;
@@ -14,4 +14,10 @@ bool isValidIPv4WithPort(const QString &input);
 
 std::string currentTime();
 
+/**
+ * Время в формате мм:сс:сотые
+ * @param msecs миллисекунды с начала эпохи
+ */
+std::string formatTime(qint64 msecs);
+
 #endif
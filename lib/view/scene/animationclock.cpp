@@ -0,0 +1,66 @@
+#include "animationclock.hpp"
+
+#include <QGraphicsScene>
+#include <QGraphicsView>
+
+#include "waveitem.hpp"
+
+AnimationClock* AnimationClock::forScene(QGraphicsScene* scene) {
+    auto* clock = scene->findChild<AnimationClock*>(
+        QString(), Qt::FindDirectChildrenOnly);
+    if (!clock) {
+        clock = new AnimationClock(scene);
+    }
+    return clock;
+}
+
+AnimationClock::AnimationClock(QGraphicsScene* scene)
+    : QObject(scene), m_scene(scene) {
+    m_timer.setInterval(kTickMsec);
+    connect(&m_timer, &QTimer::timeout, this, &AnimationClock::tick);
+    m_clock.start();
+}
+
+void AnimationClock::registerItem(WaveItem* item) {
+    if (!m_items.contains(item)) {
+        m_items.append(item);
+    }
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void AnimationClock::unregisterItem(WaveItem* item) {
+    m_items.removeOne(item);
+    if (m_items.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+void AnimationClock::tick() {
+    // видимая часть сцены во всех представлениях
+    QList<QRectF> visible;
+    for (const auto* view : m_scene->views()) {
+        if (view->isVisible()) {
+            visible.append(
+                view->mapToScene(view->viewport()->rect()).boundingRect());
+        }
+    }
+    if (visible.isEmpty()) {
+        return;
+    }
+
+    const qint64 now = m_clock.elapsed();
+    for (auto* item : std::as_const(m_items)) {
+        if (!item->isVisible()) {
+            continue;
+        }
+        const QRectF rect = item->sceneBoundingRect();
+        for (const auto& area : std::as_const(visible)) {
+            if (area.intersects(rect)) {
+                item->advanceTo(now);
+                break;
+            }
+        }
+    }
+}
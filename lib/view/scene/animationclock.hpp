@@ -0,0 +1,50 @@
+#ifndef APP_ANIMATIONCLOCK_HPP
+#define APP_ANIMATIONCLOCK_HPP
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+class QGraphicsScene;
+class WaveItem;
+
+/**
+ * Общие часы анимации сцены: один таймер на все волны.
+ * За тик сдвигает фазу только видимых волн, попадающих в область
+ * просмотра хотя бы одного QGraphicsView; их update() сцена сливает
+ * в одну перерисовку.
+ */
+class AnimationClock : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr int kTickMsec = 25;
+
+    /**
+     * Часы сцены, создаются при первом обращении и принадлежат сцене
+     */
+    static AnimationClock* forScene(QGraphicsScene* scene);
+
+    void registerItem(WaveItem* item);
+
+    void unregisterItem(WaveItem* item);
+
+    /**
+     * Время с запуска часов, мс
+     */
+    [[nodiscard]] qint64 elapsed() const { return m_clock.elapsed(); }
+
+   private:
+    explicit AnimationClock(QGraphicsScene* scene);
+
+    QGraphicsScene* m_scene;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QList<WaveItem*> m_items;
+
+   private slots:
+    void tick();
+};
+
+#endif  //APP_ANIMATIONCLOCK_HPP
@@ -15,6 +15,7 @@ class BeaconItem : public QGraphicsEllipseItem {
 public:
     BeaconItem(const QString &name, qreal x, qreal y, qreal radius = 12.0)
         : QGraphicsEllipseItem(-radius, -radius, radius * 2, radius * 2),
+          m_title(name),
           m_name(QString("%1\n(%2, %3)").arg(name).arg(x).arg(y)), m_x(x), m_y(y), m_radius(radius) {
         setPos(x * CELL_SIZE, -y * CELL_SIZE);
         setPen(Qt::NoPen);
@@ -57,7 +58,20 @@ public:
 
     QString name() const { return m_name; }
 
+    /**
+     * Перемещает маяк без пересоздания элемента
+     * @param x, y координаты в метрах
+     */
+    void setCoords(qreal x, qreal y) {
+        if (x == m_x && y == m_y) return;
+        m_x = x;
+        m_y = y;
+        setPos(x * CELL_SIZE, -y * CELL_SIZE);
+        setName(QString("%1\n(%2, %3)").arg(m_title).arg(x).arg(y));
+    }
+
 private:
+    QString m_title;
     QString m_name;
     QList<WaveItem *> m_waves;
     qreal m_radius;
@@ -6,6 +6,10 @@ constexpr float CELL_SIZE = 30.0f;
 constexpr float COUNT_CELLS = 100;
 constexpr int MAX_ZOOM = 12;
 
+// Через сколько мс без позиций маркер устройства возвращается в пул
+constexpr int kTagTimeoutMsec = 30000;
+constexpr int kTagSweepMsec = 1000;
+
 
 const QColor kPrimaryColor[3] = {
     QColor("#F50057"),
@@ -2,13 +2,29 @@
 #define APP_GRIDITEM_HPP
 
 #include <QGraphicsItem>
+#include <QPainter>
 #include <QPen>
+#include <QPixmap>
+#include <QStyleOptionGraphicsItem>
 
+#include <algorithm>
+#include <cmath>
+
+#include "const.hpp"
+
+// Сетка рисуется из закэшированной плитки и только в пределах exposedRect.
+// Плитка перестраивается лишь при смене масштаба.
 class GridItem : public QGraphicsItem {
 public:
+    // Линии ближе этого расстояния (в пикселях) прореживаются через одну
+    static constexpr qreal kMinLinePixels = 6.0;
+    // Примерный размер плитки в пикселях
+    static constexpr qreal kTilePixels = 256.0;
+
     GridItem(qreal spacing = 50.0, QGraphicsItem *parent = nullptr)
         : QGraphicsItem(parent), m_spacing(spacing) {
         setZValue(-100); // сетка всегда позади
+        setFlag(ItemUsesExtendedStyleOption); // нужен exposedRect
     }
 
     QRectF boundingRect() const override {
@@ -17,19 +33,64 @@ public:
                       COUNT_CELLS * 2 * CELL_SIZE);
     }
 
-    void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) override {
-        painter->setPen(QPen(kGridColor, 0));
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) override {
         const QRectF rect = boundingRect();
+        const QRectF exposed = option->exposedRect & rect;
+        if (exposed.isEmpty()) return;
 
-        for (qreal x = rect.left(); x <= rect.right(); x += m_spacing)
-            painter->drawLine(QPointF(x, rect.top()), QPointF(x, rect.bottom()));
+        const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+            painter->worldTransform());
+        if (lod <= 0) return;
+        if (m_tile.isNull() || !qFuzzyCompare(m_tileLod, lod)) {
+            rebuildTile(lod);
+        }
 
-        for (qreal y = rect.top(); y <= rect.bottom(); y += m_spacing)
-            painter->drawLine(QPointF(rect.left(), y), QPointF(rect.right(), y));
+        // плитка начинается на линии сетки: смещение от левого верхнего угла
+        const QPointF offset(std::fmod(exposed.left() - rect.left(), m_tileSize),
+                             std::fmod(exposed.top() - rect.top(), m_tileSize));
+        painter->save();
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter->drawTiledPixmap(exposed, m_tile, offset);
+        painter->restore();
     }
 
 private:
     qreal m_spacing;
+
+    QPixmap m_tile;
+    qreal m_tileLod = 0;
+    qreal m_tileSize = 0;  // в координатах элемента
+
+    void rebuildTile(qreal lod) {
+        m_tileLod = lod;
+
+        // при отдалении оставляем каждую 2-ю, 4-ю ... линию
+        qreal step = m_spacing;
+        while (step * lod < kMinLinePixels) step *= 2;
+
+        const int lines = std::max(1, static_cast<int>(kTilePixels / (step * lod)));
+        m_tileSize = step * lines;
+
+        // размер в пикселях целый, поэтому плотность чуть выше lod,
+        // зато логический размер плитки ровно m_tileSize и линии не «плывут»
+        const int pixels = std::max(1, static_cast<int>(std::ceil(m_tileSize * lod)));
+        const qreal ratio = pixels / m_tileSize;
+
+        QPixmap tile(pixels, pixels);
+        tile.fill(Qt::transparent);
+        {
+            QPainter p(&tile);
+            p.setPen(QPen(kGridColor, 0));
+            p.scale(ratio, ratio);
+            for (int i = 0; i < lines; ++i) {
+                const qreal c = i * step;
+                p.drawLine(QPointF(c, 0), QPointF(c, m_tileSize));
+                p.drawLine(QPointF(0, c), QPointF(m_tileSize, c));
+            }
+        }
+        tile.setDevicePixelRatio(ratio);
+        m_tile = tile;
+    }
 };
 
 
@@ -0,0 +1,55 @@
+#ifndef APP_HEATMAPITEM_HPP
+#define APP_HEATMAPITEM_HPP
+
+#include <QGraphicsItem>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QStyleOptionGraphicsItem>
+
+#include "const.hpp"
+
+// Тепловая карта одним слоем: картинка приходит готовой из потока карты,
+// здесь только растягивается на свою область и рисуется в пределах exposedRect.
+class HeatmapItem : public QGraphicsItem {
+public:
+    explicit HeatmapItem(QGraphicsItem *parent = nullptr) : QGraphicsItem(parent) {
+        setZValue(-90); // над сеткой, под траекторией и метками
+        setFlag(ItemUsesExtendedStyleOption); // нужен exposedRect
+        setAcceptedMouseButtons(Qt::NoButton);
+    }
+
+    // area - область картинки в метрах, строка 0 картинки - наибольший y
+    void setImage(const QImage &image, const QRectF &area) {
+        prepareGeometryChange();
+        m_pixmap = QPixmap::fromImage(image);
+        m_rect = QRectF(area.left() * CELL_SIZE, -area.bottom() * CELL_SIZE,
+                        area.width() * CELL_SIZE, area.height() * CELL_SIZE);
+        update();
+    }
+
+    QRectF boundingRect() const override { return m_rect; }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) override {
+        if (m_pixmap.isNull()) return;
+        const QRectF exposed = option->exposedRect & m_rect;
+        if (exposed.isEmpty()) return;
+
+        // тот же прямоугольник в пикселях картинки
+        const qreal sx = m_pixmap.width() / m_rect.width();
+        const qreal sy = m_pixmap.height() / m_rect.height();
+        const QRectF source((exposed.left() - m_rect.left()) * sx,
+                            (exposed.top() - m_rect.top()) * sy, exposed.width() * sx,
+                            exposed.height() * sy);
+        painter->save();
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter->drawPixmap(exposed, m_pixmap, source);
+        painter->restore();
+    }
+
+private:
+    QPixmap m_pixmap;
+    QRectF m_rect;
+};
+
+#endif //APP_HEATMAPITEM_HPP
@@ -5,19 +5,20 @@
 #include <QGraphicsView>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <algorithm>
 #include <cmath>
 
 #include "beaconitem.hpp"
 #include "const.hpp"
-#include "espitem.hpp"
 #include "griditem.hpp"
-#include "pointitem.hpp"
+#include "heatmapitem.hpp"
 
 Scene::Scene(Model* model, QWidget* parent)
     : QWidget(parent),
       m_model(model),
       m_scene(new QGraphicsScene(this)),
-      m_view(new QGraphicsView(m_scene, this)) {
+      m_view(new SceneView(m_scene, this)),
+      m_sweepTimer(new QTimer(this)) {
     // Размещение QGraphicsView во всём окне
     m_layout = new QVBoxLayout(this);
     m_layout->setContentsMargins(0, 0, 0, 0);
@@ -34,11 +35,16 @@ Scene::Scene(Model* model, QWidget* parent)
     m_view->setBackgroundBrush(QBrush(kBackgroundColor));
 
     setupBasicScene();
+
+    connect(m_model->heatmap(), &Heatmap::imageReady, this, &Scene::onHeatmapReady);
+
+    m_clock.start();
+    connect(m_sweepTimer, &QTimer::timeout, this, &Scene::sweepTags);
+    m_sweepTimer->start(kTagSweepMsec);
 }
 
 Scene::~Scene() {
     delete m_view;
-    delete m_esp;
     delete m_layout;
 }
 
@@ -48,69 +54,166 @@ void Scene::keyPressEvent(QKeyEvent* event) {
         if (m_zoomCounter < MAX_ZOOM) {
             m_view->scale(1.1, 1.1);
             m_zoomCounter++;
+            updateHeatmapScale();
         }
     } else if (event->key() == Qt::Key_Minus) {
         if (-m_zoomCounter < MAX_ZOOM) {
             m_view->scale(0.9, 0.9);
             m_zoomCounter--;
+            updateHeatmapScale();
+        }
+    } else if (event->key() == Qt::Key_H) {
+        switch (m_heatmapMode) {
+            case HeatmapMode::OFF: setHeatmapMode(HeatmapMode::HISTORY); break;
+            case HeatmapMode::HISTORY: setHeatmapMode(HeatmapMode::LIVE); break;
+            case HeatmapMode::LIVE: setHeatmapMode(HeatmapMode::OFF); break;
         }
     }
 }
 
+void Scene::setHeatmapMode(HeatmapMode mode) {
+    m_heatmapMode = mode;
+    m_heatmapItem->setVisible(mode != HeatmapMode::OFF);
+    const bool rendering = mode != HeatmapMode::OFF;
+    const auto layer = mode == HeatmapMode::LIVE ? HeatmapTiles::Layer::LIVE
+                                                 : HeatmapTiles::Layer::HISTORY;
+    QMetaObject::invokeMethod(m_model->heatmap(),
+                              [heatmap = m_model->heatmap(), rendering, layer] {
+                                  heatmap->setLayer(layer);
+                                  heatmap->setRendering(rendering);
+                              });
+}
+
+void Scene::updateHeatmapScale() {
+    // пикселей экрана на метр: масштаб вида на пиксели сцены в метре
+    const double pixelsPerMeter = m_view->transform().m11() * CELL_SIZE;
+    QMetaObject::invokeMethod(m_model->heatmap(),
+                              [heatmap = m_model->heatmap(), pixelsPerMeter] {
+                                  heatmap->setPixelsPerMeter(pixelsPerMeter);
+                              });
+}
+
+void Scene::onHeatmapReady(const QImage& image, const QRectF& area) {
+    m_heatmapItem->setImage(image, area);
+}
+
 void Scene::setupBasicScene() {
-    clearScene();
     m_scene->addItem(new GridItem(CELL_SIZE));  // сетка
-    m_esp = new EspItem("CONNECTED", 10);
-    m_scene->addItem(m_esp);
-    m_esp->setPos(0, 0);
+    m_heatmapItem = new HeatmapItem();
+    m_heatmapItem->setVisible(false);
+    m_scene->addItem(m_heatmapItem);
+    updateHeatmapScale();
     m_pathItems = new QGraphicsPathItem();
     m_scene->addItem(m_pathItems);
     m_pathItems->setPen(QPen(kPathColor[0], 2));
-}
-
-void Scene::clearScene() {
-    m_scene->clear();
+    m_tagPool = std::make_unique<TagItemPool>(m_scene);
 }
 
 void Scene::beaconChanged() {
-    setupBasicScene();
+    // элементы пересоздаются только для новых маяков,
+    // у существующих меняется позиция, удалённые убираются со сцены
     const auto beacons = m_model->beacons();
+    QHash<QString, BeaconItem*> items;
+    items.reserve(beacons.size());
     for (const auto& beacon : beacons) {
         const auto pos = beacon.pos();
-        m_scene->addItem(new BeaconItem(beacon.name(), pos.x(), pos.y()));
+        auto* item = m_beaconItems.take(beacon.name());
+        if (item) {
+            item->setCoords(pos.x(), pos.y());
+        } else if (!items.contains(beacon.name())) {
+            item = new BeaconItem(beacon.name(), pos.x(), pos.y());
+            m_scene->addItem(item);
+        } else {
+            continue;
+        }
+        items.insert(beacon.name(), item);
     }
-    update();
+    qDeleteAll(m_beaconItems);
+    m_beaconItems = std::move(items);
 }
 
 void Scene::espChanged() {
-    const auto eo = m_model->esp();
-    const auto pos = eo.pos();
-    m_esp->setPos(pos.x() * CELL_SIZE, -pos.y() * CELL_SIZE);
-    m_esp->setStatus(m_model->status());
-    const auto path = m_model->path();
-    QPainterPath pp;
-    if (path.isEmpty()) {
-        pp.moveTo(QPointF(pos.x() * CELL_SIZE, -pos.y() * CELL_SIZE));
-    } else {
-        pp.moveTo(QPointF(path[0].x() * CELL_SIZE, -path[0].y() * CELL_SIZE));
-        for (int i = 1; i < path.size(); i++) {
-            pp.lineTo(
-                QPointF(path[i].x() * CELL_SIZE, -path[i].y() * CELL_SIZE));
-            auto* item =
-                new PointItem(pos.x(), pos.y(), kPathColor[1], 2);  // NOLINT
-            item->setParentItem(m_pathItems);
+    tracing::Span span(tracing::Stage::SCENE_UPDATE);
+    appendPathSegments();
+}
+
+void Scene::onTagsMoved(const QList<TagPosition>& positions) {
+    tracing::Span span(tracing::Stage::SCENE_UPDATE);
+    const qint64 now = m_clock.elapsed();
+    for (const auto& p : positions) {
+        m_view->traceShown(p.trace);
+        auto*& item = m_tags[p.tag];
+        if (!item) {
+            item = m_tagPool->acquire(p.tag);
+        }
+        item->push(QPointF(p.pos.x() * CELL_SIZE, -p.pos.y() * CELL_SIZE),
+                   now);
+    }
+    // перерисовываем каждое устройство один раз за пачку
+    const auto status = m_model->status();
+    for (auto* item : std::as_const(m_tags)) {
+        item->flush(status);
+    }
+}
+
+void Scene::sweepTags() {
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_tags.begin(); it != m_tags.end();) {
+        if (now - it.value()->lastSeen() > kTagTimeoutMsec) {
+            m_tagPool->release(it.value());
+            it = m_tags.erase(it);
+        } else {
+            ++it;
         }
     }
-    m_pathItems->setPath(pp);
+}
 
-    update();
+void Scene::appendPathSegments() {
+    const auto& path = m_model->path();
+    const auto toScene = [](const QPointF& p) {
+        return QPointF(p.x() * CELL_SIZE, -p.y() * CELL_SIZE);
+    };
+    // полная история рисуется для устройства по умолчанию (и загруженного
+    // из файла пути), у остальных устройств - только короткий след TagItem
+    constexpr quint32 kHistoryTag = 0;
+    while (m_drawnPoints < path.size()) {
+        const qsizetype chunk = m_drawnPoints / PathStorage::kChunkSize;
+        if (chunk >= m_pathSegments.size()) {
+            auto* segment = new QGraphicsPathItem(m_pathItems);
+            segment->setPen(QPen(kPathColor[0], 2));
+            m_pathSegments.append(segment);
+        }
+        auto* segment = m_pathSegments[chunk];
+        QPainterPath pp = segment->path();
+        const qsizetype end =
+            std::min(path.size(), (chunk + 1) * PathStorage::kChunkSize);
+        for (; m_drawnPoints < end; ++m_drawnPoints) {
+            const auto& point = path.at(m_drawnPoints);
+            if (point.tag != kHistoryTag) {
+                continue;
+            }
+            const auto p = toScene(point.pos);
+            if (pp.elementCount() == 0) {
+                // новый отрезок продолжает предыдущий с его последней точки
+                pp.moveTo(m_hasHistoryPoint ? m_lastHistoryPoint : p);
+            }
+            pp.lineTo(p);
+            m_lastHistoryPoint = p;
+            m_hasHistoryPoint = true;
+        }
+        segment->setPath(pp);
+    }
+}
+
+void Scene::resetPathSegments() {
+    qDeleteAll(m_pathSegments);
+    m_pathSegments.clear();
+    m_drawnPoints = 0;
+    m_hasHistoryPoint = false;
 }
 
 void Scene::onPathChanged() {
-    delete m_pathItems;
-    m_pathItems = new QGraphicsPathItem();
-    m_pathItems->setPen(QPen(kPathColor[0], 2));
-    m_scene->addItem(m_pathItems);
+    resetPathSegments();
     update();
 }
 
@@ -118,3 +221,13 @@ void Scene::onPathSeted() {
     onPathChanged();
     espChanged();
 }
+
+void Scene::onPathTrimmed(qsizetype count) {
+    // вытеснение идёт целыми чанками, вместе с ними уходят их отрезки
+    const qsizetype segments =
+        std::min(count / PathStorage::kChunkSize, m_pathSegments.size());
+    for (qsizetype i = 0; i < segments; ++i) {
+        delete m_pathSegments.takeFirst();
+    }
+    m_drawnPoints = std::max<qsizetype>(0, m_drawnPoints - count);
+}
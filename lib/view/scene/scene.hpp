@@ -6,10 +6,16 @@
 #include <QVBoxLayout>
 #include <QPropertyAnimation>
 
-#include "espitem.hpp"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
 #include "model.hpp"
+#include "sceneview.hpp"
+#include "tagitem.hpp"
 
-class PointItem;
+class BeaconItem;
+class HeatmapItem;
 class Scene : public QWidget {
     Q_OBJECT
 
@@ -24,21 +30,43 @@ class Scene : public QWidget {
    private:
     Model* m_model;
     QGraphicsScene* m_scene;
-    QGraphicsView* m_view;
-    EspItem* m_esp;
+    SceneView* m_view;
 
     QVBoxLayout* m_layout;
 
-    QList<PointItem*> m_items;
+    QHash<QString, BeaconItem*> m_beaconItems;
 
-    void setupBasicScene();
+    std::unique_ptr<TagItemPool> m_tagPool;
+    QHash<QString, TagItem*> m_tags;
+    QElapsedTimer m_clock;
+    QTimer* m_sweepTimer;
 
-    void clearScene();
+    void setupBasicScene();
 
     int m_zoomCounter = 0;
 
+    // Тепловая карта: H переключает выкл -> история -> последние минуты
+    enum class HeatmapMode { OFF, HISTORY, LIVE };
+    HeatmapItem* m_heatmapItem;
+    HeatmapMode m_heatmapMode = HeatmapMode::OFF;
+
+    void setHeatmapMode(HeatmapMode mode);
+
+    void updateHeatmapScale();
+
     QGraphicsPathItem* m_pathItems;
 
+    // По одному отрезку траектории на чанк PathStorage:
+    // при добавлении перестраивается только последний
+    QList<QGraphicsPathItem*> m_pathSegments;
+    qsizetype m_drawnPoints = 0;
+    QPointF m_lastHistoryPoint;
+    bool m_hasHistoryPoint = false;
+
+    void appendPathSegments();
+
+    void resetPathSegments();
+
    public slots:
     void beaconChanged();
 
@@ -47,6 +75,17 @@ class Scene : public QWidget {
     void onPathChanged();
 
     void onPathSeted();
+
+    void onPathTrimmed(qsizetype count);
+
+    void onTagsMoved(const QList<TagPosition>& positions);
+
+    void onHeatmapReady(const QImage& image, const QRectF& area);
+
+    /**
+     * Возвращает в пул маркеры устройств, давно не присылавших позицию
+     */
+    void sweepTags();
 };
 
 #endif  //APP_SCENE_HPP
@@ -0,0 +1,49 @@
+#ifndef APP_SCENEVIEW_HPP
+#define APP_SCENEVIEW_HPP
+
+#include <QGraphicsView>
+#include <QList>
+#include <QPaintEvent>
+
+#include "tracing/trace.h"
+
+// QGraphicsView, замеряющий отрисовку для трассировки: позиции, пришедшие
+// после прошлого кадра, получают этап SCENE_PAINT ближайшей отрисовки.
+class SceneView : public QGraphicsView {
+public:
+    // больше позиций за кадр не связываем: в трассе нужен путь, а не каждая точка
+    static constexpr qsizetype kMaxTracedPerFrame = 256;
+
+    explicit SceneView(QGraphicsScene *scene, QWidget *parent = nullptr)
+        : QGraphicsView(scene, parent) {}
+
+    void traceShown(quint64 id) {
+        if (id && m_traced.size() < kMaxTracedPerFrame) {
+            m_traced.append(id);
+        }
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        if (!tracing::enabled()) {
+            m_traced.clear();
+            QGraphicsView::paintEvent(event);
+            return;
+        }
+        const std::uint64_t start = tracing::now();
+        QGraphicsView::paintEvent(event);
+        const std::uint64_t end = tracing::now();
+        if (m_traced.isEmpty()) {
+            tracing::record(tracing::Stage::SCENE_PAINT, start, end);
+        }
+        for (const quint64 id : std::as_const(m_traced)) {
+            tracing::record(tracing::Stage::SCENE_PAINT, start, end, id);
+        }
+        m_traced.clear();
+    }
+
+private:
+    QList<quint64> m_traced;
+};
+
+#endif  //APP_SCENEVIEW_HPP
@@ -0,0 +1,145 @@
+#ifndef APP_TAGITEM_HPP
+#define APP_TAGITEM_HPP
+
+#include <QGraphicsPathItem>
+#include <QGraphicsScene>
+#include <QList>
+#include <QPainterPath>
+#include <QPen>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "const.hpp"
+#include "espitem.hpp"
+
+/**
+ * Маркер и короткий след одного устройства.
+ * Графические элементы создаются один раз и принадлежат сцене,
+ * между устройствами они только скрываются и показываются снова.
+ */
+class TagItem {
+   public:
+    static constexpr int kTrailLength = 128;
+
+    explicit TagItem(QGraphicsScene* scene)
+        : m_marker(new EspItem(QString(), 10)),
+          m_trail(new QGraphicsPathItem()) {
+        m_trail->setPen(QPen(kPathColor[0], 2));
+        m_trail->setZValue(8);
+        scene->addItem(m_trail);
+        scene->addItem(m_marker);
+        m_marker->hide();
+        m_trail->hide();
+    }
+
+    void activate(const QString& tag) {
+        m_tag = tag;
+        m_trailSize = 0;
+        m_trailHead = 0;
+        m_dirty = false;
+        m_trail->setPath(QPainterPath());
+        m_marker->show();
+        m_trail->show();
+    }
+
+    void deactivate() {
+        m_marker->hide();
+        m_trail->hide();
+        m_tag.clear();
+    }
+
+    [[nodiscard]] const QString& tag() const { return m_tag; }
+
+    [[nodiscard]] qint64 lastSeen() const { return m_lastSeen; }
+
+    /**
+     * Запоминает новую позицию, перерисовка - в flush()
+     * @param scenePos позиция в координатах сцены
+     * @param now текущее время, мс
+     */
+    void push(const QPointF& scenePos, qint64 now) {
+        m_points[m_trailHead] = scenePos;
+        m_trailHead = (m_trailHead + 1) % kTrailLength;
+        if (m_trailSize < kTrailLength) {
+            ++m_trailSize;
+        }
+        m_lastSeen = now;
+        m_dirty = true;
+    }
+
+    /**
+     * Применяет накопленные позиции к маркеру и следу
+     * @param status состояние подключения для подписи маркера
+     * @return была ли перерисовка
+     */
+    bool flush(const QString& status) {
+        if (!m_dirty) {
+            return false;
+        }
+        m_dirty = false;
+        const int first =
+            (m_trailHead - m_trailSize + kTrailLength) % kTrailLength;
+        QPainterPath pp(m_points[first]);
+        for (int i = 1; i < m_trailSize; ++i) {
+            pp.lineTo(m_points[(first + i) % kTrailLength]);
+        }
+        m_trail->setPath(pp);
+        m_marker->setPos(pp.currentPosition());
+        m_marker->setStatus(QString("%1: %2").arg(m_tag, status));
+        return true;
+    }
+
+   private:
+    EspItem* m_marker;
+    QGraphicsPathItem* m_trail;
+    QString m_tag;
+    std::array<QPointF, kTrailLength> m_points;
+    int m_trailHead = 0;
+    int m_trailSize = 0;
+    qint64 m_lastSeen = 0;
+    bool m_dirty = false;
+};
+
+/**
+ * Пул маркеров устройств: появление и исчезновение устройства
+ * не создаёт и не удаляет QGraphicsItem, пока пул не исчерпан.
+ */
+class TagItemPool {
+   public:
+    explicit TagItemPool(QGraphicsScene* scene, int preallocated = 32)
+        : m_scene(scene) {
+        for (int i = 0; i < preallocated; ++i) {
+            m_items.push_back(std::make_unique<TagItem>(m_scene));
+            m_free.append(m_items.back().get());
+        }
+    }
+
+    TagItem* acquire(const QString& tag) {
+        if (m_free.isEmpty()) {
+            m_items.push_back(std::make_unique<TagItem>(m_scene));
+            m_free.append(m_items.back().get());
+        }
+        auto* item = m_free.takeLast();
+        item->activate(tag);
+        return item;
+    }
+
+    void release(TagItem* item) {
+        item->deactivate();
+        m_free.append(item);
+    }
+
+    [[nodiscard]] qsizetype size() const {
+        return static_cast<qsizetype>(m_items.size());
+    }
+
+   private:
+    QGraphicsScene* m_scene;
+    // сами QGraphicsItem удаляет сцена, здесь - только обёртки
+    std::vector<std::unique_ptr<TagItem>> m_items;
+    QList<TagItem*> m_free;
+};
+
+#endif  //APP_TAGITEM_HPP
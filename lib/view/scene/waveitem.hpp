@@ -3,18 +3,21 @@
 
 #include <QGraphicsEllipseItem>
 #include <QGraphicsItem>
-#include <QTimer>
+#include <QGraphicsScene>
 #include <QPainter>
 #include <QLinearGradient>
 #include <QBrush>
+#include <QPointer>
 #include <QVector>
 
-#include "const.hpp"
+#include <cmath>
 
-// Класс волн
-class WaveItem : public QObject, public QGraphicsItem {
-    Q_OBJECT
+#include "animationclock.hpp"
+#include "const.hpp"
 
+// Класс волн. Фаза считается от общих часов сцены (AnimationClock):
+// радиус растёт на 1 каждые msec мс после задержки delay
+class WaveItem : public QGraphicsItem {
 public:
     explicit WaveItem(
         qreal minRadius,
@@ -29,11 +32,12 @@ public:
           m_second(second),
           m_maxRadius(maxRadius),
           m_radius(0.0),
-          m_timer(new QTimer(this)), m_msec(msec), m_delayTimer(new QTimer(this)) {
-        connect(m_timer, &QTimer::timeout, this, &WaveItem::onUpdateTimer);
-        connect(m_delayTimer, &QTimer::timeout, this, &WaveItem::startTimer);
-        m_delayTimer->setSingleShot(true);
-        m_delayTimer->start(delay);
+          m_msec(msec), m_delay(delay) {}
+
+    ~WaveItem() override {
+        if (m_clock) {
+            m_clock->unregisterItem(this);
+        }
     }
 
     QRectF boundingRect() const override {
@@ -63,27 +67,45 @@ public:
         painter->drawEllipse(QPointF(0, 0), radius, radius);
     }
 
-private slots:
-    void onUpdateTimer() {
-        m_radius += 1.0;
-        if (m_radius > m_maxRadius)
-            m_radius = 0.0;
+    /**
+     * Выставляет фазу на момент now (мс по часам сцены)
+     */
+    void advanceTo(qint64 now) {
+        qreal radius = 0.0;
+        if (now > m_delay) {
+            radius = std::fmod(static_cast<qreal>(now - m_delay) / m_msec,
+                               m_maxRadius);
+        }
+        if (radius == m_radius) return;
+        m_radius = radius;
         update();
     }
 
-    void startTimer() {
-        m_timer->start(m_msec);
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override {
+        if (change == ItemSceneChange && m_clock) {
+            m_clock->unregisterItem(this);
+            m_clock = nullptr;
+        } else if (change == ItemSceneHasChanged && scene()) {
+            attachClock(scene());
+        }
+        return QGraphicsItem::itemChange(change, value);
     }
 
 private:
     QColor m_first;
     QColor m_second;
-    QTimer *m_timer;
-    QTimer *m_delayTimer;
+    QPointer<AnimationClock> m_clock;
     qreal m_minRadius;
     qreal m_maxRadius;
     qreal m_radius;
     int m_msec;
+    int m_delay;
+
+    void attachClock(QGraphicsScene *scene) {
+        m_clock = AnimationClock::forScene(scene);
+        m_clock->registerItem(this);
+    }
 };
 
 #endif
@@ -1,8 +1,14 @@
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 #include <QObject>
+#include <QStandardPaths>
+#include <QThread>
 
 #include "mainwindow.hpp"
 #include "model.hpp"
+#include "positionbatcher.hpp"
+#include "tracing/trace.h"
 
 #include <QObject>
 
@@ -16,12 +22,49 @@ int main(int argc, char* argv[]) {
         std::make_shared<mqtt_connector::MqttClient>();
     std::shared_ptr<Model> model = std::make_shared<Model>(conn.get());
 
+    // Слоты коннектора (подключение, смена маяков) выполняются
+    // в отдельном потоке и не задерживают цикл событий GUI
+    QThread connectorThread;
+    connectorThread.setObjectName("connector");
+    conn->moveToThread(&connectorThread);
+    connectorThread.start();
+
     MainWindow window(model.get());
     window.resize(1200, 800);
     window.show();
 
+    // Позиции копятся в потоке коннектора и уходят в GUI одной пачкой за кадр
+    PositionBatcher batcher;
+    batcher.setMetrics(conn->metrics());
+
+    // Метрики для Prometheus: BACON_METRICS=host:port, без переменной - выключены
+    // (второй экземпляр на том же порту не поднялся бы)
+    const QString metricsAddress = qEnvironmentVariable("BACON_METRICS");
+    if (!metricsAddress.isEmpty() && metricsAddress != "off") {
+        metrics::ExporterOptions options;
+        const int colon = metricsAddress.lastIndexOf(':');
+        options.bind_address = metricsAddress.left(colon).toStdString();
+        options.port = metricsAddress.mid(colon + 1).toInt();
+        conn->startMetricsExporter(options);
+    }
+    // Тепловая карта переживает перезапуск: BACON_HEATMAP=файл истории
+    const QString heatmapFile = qEnvironmentVariable("BACON_HEATMAP");
+    if (!heatmapFile.isEmpty()) {
+        model->setHeatmapFile(heatmapFile);
+    }
+    // Вытесненная из памяти часть пути: BACON_PATH_SPILL=файл, "off" - не сохранять
+    const QString spillFile = qEnvironmentVariable(
+        "BACON_PATH_SPILL",
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/path.spill");
+    if (spillFile != "off" && QDir().mkpath(QFileInfo(spillFile).absolutePath())) {
+        model->setPathSpillFile(spillFile);
+    }
+    // Трассировка пути позиции: BACON_TRACE=1, дамп - GET /trace
+    tracing::setEnabled(qEnvironmentVariableIntValue("BACON_TRACE") != 0);
     QObject::connect(conn.get(), &mqtt_connector::MqttClient::addPathPoint,
-                     model.get(), &Model::addPointToPath);
+                     &batcher, &PositionBatcher::push, Qt::DirectConnection);
+    QObject::connect(&batcher, &PositionBatcher::batchReady, model.get(),
+                     &Model::addPointsToPath);
     QObject::connect(conn.get(), &mqtt_connector::MqttClient::setConnectStatus,
                      model.get(), &Model::onStatusChanged);
     QObject::connect(model.get(), &Model::urlChanged, conn.get(),
@@ -31,24 +74,15 @@ int main(int argc, char* argv[]) {
     QObject::connect(model.get(), &Model::signalBeaconsChanged, conn.get(),
                      &mqtt_connector::MqttClient::setBeacons);
 
-    // // Создаем таймер
-    // QTimer timer;
-    //
-    // float i = 0;
-    // float x, y;
-    // float size = 2;
-    //
-    // // Подключаем сигнал timeout к лямбда-функции
-    // QObject::connect(&timer, &QTimer::timeout, [&]() {
-    //     x = std::cos(i) * size;
-    //     y = std::sin(i) * size;
-    //     i += 0.1;
-    //     size += 0.01;
-    //     model->addPointToPath(QPointF(x, y));
-    // });
-    //
-    // // Таймер срабатывает каждые 1000 мс (1 секунда)
-    // timer.start(100);
-
-    return QApplication::exec();
+    const int code = QApplication::exec();
+
+    connectorThread.quit();
+    connectorThread.wait();
+    // поток обработки пишет в batcher напрямую: останавливаем его, пока
+    // локальные объекты main ещё живы, а не в деструкторе conn
+    QObject::disconnect(conn.get(), &mqtt_connector::MqttClient::addPathPoint,
+                        &batcher, &PositionBatcher::push);
+    conn->shutdown();
+
+    return code;
 }
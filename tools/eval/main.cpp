@@ -0,0 +1,401 @@
+// bacon-eval: точность и стоимость навигатора при разных настройках.
+// Один и тот же трафик (симуляция или запись с эталонным треком)
+// прогоняется через навигатор с каждой конфигурацией --config, итог -
+// таблица RMSE, p50/p95/p99 ошибки, времени сходимости и CPU на расчёт.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+
+#include "config/config.h"
+#include "mqtt_connector/advert_dedup.h"
+#include "navigator/navigator.h"
+#include "recorder/replayer.h"
+#include "simulator/traffic_generator.h"
+
+namespace {
+
+using Measurements =
+    std::vector<std::pair<std::string, std::vector<message_objects::BLEBeaconState>>>;
+
+struct Point {
+    double x = 0;
+    double y = 0;
+};
+
+/**
+ * Такт навигатора: измерения каждой метки и её истинное положение
+ */
+struct Tick {
+    double time = 0;  // с от начала
+    std::map<std::string, std::map<std::string, std::vector<message_objects::BLEBeaconState>>>
+        samples;
+    std::map<std::string, Point> truth;
+};
+
+struct NamedConfig {
+    std::string name;
+    navigator::NavigatorConfig config;
+};
+
+struct Result {
+    std::string name;
+    std::size_t solves = 0;
+    std::size_t failures = 0;
+    double rmse = 0;
+    double p50 = 0, p95 = 0, p99 = 0;
+    double convergence = 0;       // с, среднее по сошедшимся меткам
+    std::size_t unconverged = 0;
+    double cpu_mean_us = 0;
+    double cpu_p99_us = 0;
+};
+
+double threadCpuSeconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    const auto index = static_cast<std::size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void applySetting(navigator::NavigatorConfig& config, const std::string& key,
+                  double value) {
+    if (key == "alpha") config.alpha = value;
+    else if (key == "position_alpha") config.position_alpha = value;
+    else if (key == "max_jump") config.max_jump = value;
+    else if (key == "max_distance") config.max_distance = value;
+    else if (key == "path_loss_exponent") config.path_loss_exponent = value;
+    else if (key == "min_distance") config.min_distance = value;
+    else if (key == "iqr_k") config.iqr_k = value;
+    else if (key == "iterations") config.trilateration.max_iterations = static_cast<int>(value);
+    else if (key == "learning_rate") config.trilateration.learning_rate = value;
+    else if (key == "tolerance") config.trilateration.tolerance = value;
+    else throw std::invalid_argument("Unknown navigator setting: " + key);
+}
+
+/**
+ * "имя:ключ=значение,ключ=значение"
+ */
+NamedConfig parseConfig(const QString& spec) {
+    NamedConfig named;
+    const auto colon = spec.indexOf(':');
+    named.name = (colon < 0 ? spec : spec.left(colon)).toStdString();
+    if (colon >= 0) {
+        for (const auto& pair : spec.mid(colon + 1).split(',', Qt::SkipEmptyParts)) {
+            const auto kv = pair.split('=');
+            if (kv.size() != 2) {
+                throw std::invalid_argument("Bad setting: " + pair.toStdString());
+            }
+            applySetting(named.config, kv[0].trimmed().toStdString(), kv[1].toDouble());
+        }
+    }
+    return named;
+}
+
+std::vector<Tick> simulate(const std::vector<message_objects::BLEBeacon>& beacons,
+                           const simulator::GeneratorOptions& options,
+                           double duration, double tick_seconds) {
+    simulator::TrafficGenerator generator(beacons, options);
+    std::vector<Tick> ticks;
+    Tick current;
+    double tick_end = tick_seconds;
+
+    while (generator.time() < duration) {
+        generator.step([&current](const message_objects::BLEBeaconState& state) {
+            current.samples[state.tag_][state.name_].push_back(state);
+        });
+        if (generator.time() + 1e-9 >= tick_end) {
+            current.time = tick_end;
+            for (int t = 0; t < generator.tagCount(); ++t) {
+                const auto [x, y] = generator.position(t);
+                current.truth[options.tag_prefix + "-" + std::to_string(t)] = {x, y};
+            }
+            ticks.push_back(std::move(current));
+            current = Tick();
+            tick_end += tick_seconds;
+        }
+    }
+    return ticks;
+}
+
+/**
+ * Эталонный трек: строки "ts_ms,tag,x,y", положение между строками
+ * интерполируется линейно
+ */
+class Truth {
+   public:
+    explicit Truth(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) throw std::runtime_error("Cannot open " + path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string ts, tag, x, y;
+            if (!std::getline(ss, ts, ',') || !std::getline(ss, tag, ',') ||
+                !std::getline(ss, x, ',') || !std::getline(ss, y, ',')) {
+                continue;
+            }
+            try {
+                tracks_[tag].push_back({std::stoll(ts), {std::stod(x), std::stod(y)}});
+            } catch (const std::exception&) {
+                continue;  // заголовок
+            }
+        }
+        for (auto& [tag, track] : tracks_) {
+            std::sort(track.begin(), track.end(),
+                      [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+    }
+
+    bool at(const std::string& tag, std::int64_t ts_ms, Point& out) const {
+        auto it = tracks_.find(tag);
+        if (it == tracks_.end() || it->second.empty()) return false;
+        const auto& track = it->second;
+        auto next = std::lower_bound(
+            track.begin(), track.end(), ts_ms,
+            [](const auto& entry, std::int64_t t) { return entry.first < t; });
+        if (next == track.begin() || next == track.end()) return false;
+        const auto prev = std::prev(next);
+        const double k = double(ts_ms - prev->first) / double(next->first - prev->first);
+        out = {prev->second.x + k * (next->second.x - prev->second.x),
+               prev->second.y + k * (next->second.y - prev->second.y)};
+        return true;
+    }
+
+   private:
+    std::map<std::string, std::vector<std::pair<std::int64_t, Point>>> tracks_;
+};
+
+std::vector<Tick> fromCapture(recorder::SampleSource& source, const Truth& truth,
+                              double tick_seconds) {
+    const auto tick_us = static_cast<std::int64_t>(tick_seconds * 1e6);
+    std::vector<Tick> ticks;
+    Tick current;
+    recorder::AdvertSample sample;
+    std::int64_t first_us = -1;
+    std::int64_t tick_end_us = 0;
+
+    auto close = [&](std::int64_t end_us) {
+        current.time = (end_us - first_us) / 1e6;
+        for (const auto& [tag, beacons] : current.samples) {
+            Point p;
+            if (truth.at(tag, end_us / 1000, p)) current.truth[tag] = p;
+        }
+        ticks.push_back(std::move(current));
+        current = Tick();
+    };
+
+    while (source.next(sample)) {
+        if (first_us < 0) {
+            first_us = sample.timestamp_us;
+            tick_end_us = first_us + tick_us;
+        }
+        while (sample.timestamp_us >= tick_end_us) {
+            close(tick_end_us);
+            tick_end_us += tick_us;
+        }
+        current.samples[sample.state.tag_][sample.state.name_].push_back(sample.state);
+    }
+    if (first_us >= 0) close(tick_end_us);
+    return ticks;
+}
+
+Result evaluate(const NamedConfig& named,
+                const std::vector<message_objects::BLEBeacon>& beacons,
+                const std::vector<Tick>& ticks, double converge_m,
+                int converge_ticks, bool fuse) {
+    Result result;
+    result.name = named.name;
+
+    std::map<std::string, navigator::Navigator> navigators;
+    std::map<std::string, double> first_seen;
+    std::map<std::string, std::pair<int, double>> streak;  // длина, начало
+    std::map<std::string, double> converged_at;
+    std::vector<double> errors;
+    std::vector<double> cpu;
+
+    for (const auto& tick : ticks) {
+        for (const auto& [tag, samples] : tick.samples) {
+            auto truth = tick.truth.find(tag);
+            if (truth == tick.truth.end()) continue;
+
+            auto nav = navigators.try_emplace(tag, beacons, named.config).first;
+            first_seen.try_emplace(tag, tick.time);
+
+            Measurements measurements(samples.begin(), samples.end());
+            const double cpu_start = threadCpuSeconds();
+            if (fuse) {
+                // как в MqttClient::processTick: копии шлюзов - одно измерение
+                for (auto& [beacon, states] : measurements) {
+                    mqtt_connector::fuseGatewayCopies(states);
+                }
+            }
+            std::pair<double, double> position;
+            try {
+                position = nav->second.calculatePosition(measurements);
+            } catch (const std::exception&) {
+                ++result.failures;
+                continue;
+            }
+            cpu.push_back((threadCpuSeconds() - cpu_start) * 1e6);
+
+            const double error = std::hypot(position.first - truth->second.x,
+                                            position.second - truth->second.y);
+            errors.push_back(error);
+
+            // сходимость: converge_ticks тактов подряд с ошибкой меньше порога
+            auto& [length, start] = streak[tag];
+            if (error < converge_m) {
+                if (length++ == 0) start = tick.time;
+                if (length == converge_ticks) {
+                    converged_at.try_emplace(tag, start - first_seen[tag]);
+                }
+            } else {
+                length = 0;
+            }
+        }
+    }
+
+    result.solves = errors.size();
+    double square_sum = 0;
+    for (double e : errors) square_sum += e * e;
+    result.rmse = errors.empty() ? 0 : std::sqrt(square_sum / errors.size());
+    result.p50 = percentile(errors, 0.50);
+    result.p95 = percentile(errors, 0.95);
+    result.p99 = percentile(errors, 0.99);
+
+    double convergence_sum = 0;
+    for (const auto& [tag, time] : converged_at) convergence_sum += time;
+    result.convergence = converged_at.empty() ? 0 : convergence_sum / converged_at.size();
+    result.unconverged = first_seen.size() - converged_at.size();
+
+    double cpu_sum = 0;
+    for (double c : cpu) cpu_sum += c;
+    result.cpu_mean_us = cpu.empty() ? 0 : cpu_sum / cpu.size();
+    result.cpu_p99_us = percentile(cpu, 0.99);
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bacon-eval");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Navigator accuracy and cost evaluation");
+    parser.addHelpOption();
+    parser.addOption({{"b", "beacons"}, "Beacon file (name;x;y).", "file"});
+    parser.addOption({{"c", "config"},
+                      "Navigator configuration name:key=value,... (repeatable). "
+                      "Keys: alpha, position_alpha, max_jump, max_distance, "
+                      "path_loss_exponent, min_distance, iqr_k, iterations, "
+                      "learning_rate, tolerance.",
+                      "spec"});
+    parser.addOption({"capture", "Recorded adverts (.blog or CSV) instead of simulation.", "file"});
+    parser.addOption({"truth", "Ground truth for --capture: ts_ms,tag,x,y.", "file"});
+    parser.addOption({{"t", "tags"}, "Simulated tags.", "n", "10"});
+    parser.addOption({{"d", "duration"}, "Simulated time, seconds.", "s", "300"});
+    parser.addOption({"seed", "Simulation seed.", "n", "1"});
+    parser.addOption({"shadowing", "Simulated shadowing sigma, dB.", "db", "4"});
+    parser.addOption({"rician-k", "Simulated Rician K factor.", "k", "4"});
+    parser.addOption({"gateways", "Simulated gateways relaying each advert.", "n", "1"});
+    parser.addOption({"no-fusion", "Feed gateway copies to the navigator unfused."});
+    parser.addOption({"freq", "Navigator ticks per second.", "hz", "1"});
+    parser.addOption({"converge-m", "Convergence error threshold, m.", "m", "2.5"});
+    parser.addOption({"converge-ticks", "Ticks below threshold to count as converged.", "n", "5"});
+    parser.addOption({"json", "Print results as JSON."});
+    parser.process(app);
+
+    if (!parser.isSet("beacons") || (parser.isSet("capture") && !parser.isSet("truth"))) {
+        parser.showHelp(1);
+    }
+
+    std::vector<message_objects::BLEBeacon> beacons;
+    std::vector<NamedConfig> configs;
+    std::vector<Tick> ticks;
+    const double tick_seconds = 1.0 / std::max(0.001, parser.value("freq").toDouble());
+    try {
+        beacons = ConfigReader(parser.value("beacons").toStdString()).readBeacons();
+        for (const auto& spec : parser.values("config")) {
+            configs.push_back(parseConfig(spec));
+        }
+        if (configs.empty()) configs.push_back({"default", {}});
+
+        if (parser.isSet("capture")) {
+            auto source = recorder::openSamples(parser.value("capture").toStdString(),
+                                                "hakaton/board");
+            ticks = fromCapture(*source, Truth(parser.value("truth").toStdString()),
+                                tick_seconds);
+        } else {
+            simulator::GeneratorOptions options;
+            options.tags = parser.value("tags").toInt();
+            options.seed = parser.value("seed").toULongLong();
+            options.radio.shadowing_sigma_db = parser.value("shadowing").toDouble();
+            options.radio.rician_k = parser.value("rician-k").toDouble();
+            options.gateways = std::max(1, parser.value("gateways").toInt());
+            ticks = simulate(beacons, options, parser.value("duration").toDouble(),
+                             tick_seconds);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (const auto& named : configs) {
+        results.push_back(evaluate(named, beacons, ticks, parser.value("converge-m").toDouble(),
+                                   parser.value("converge-ticks").toInt(),
+                                   !parser.isSet("no-fusion")));
+    }
+
+    if (parser.isSet("json")) {
+        nlohmann::json out = nlohmann::json::array();
+        for (const auto& r : results) {
+            out.push_back({{"config", r.name},
+                           {"solves", r.solves},
+                           {"failures", r.failures},
+                           {"rmse_m", r.rmse},
+                           {"p50_m", r.p50},
+                           {"p95_m", r.p95},
+                           {"p99_m", r.p99},
+                           {"convergence_s", r.convergence},
+                           {"unconverged_tags", r.unconverged},
+                           {"cpu_mean_us", r.cpu_mean_us},
+                           {"cpu_p99_us", r.cpu_p99_us}});
+        }
+        std::cout << out.dump(2) << std::endl;
+        return 0;
+    }
+
+    std::printf("%-16s %8s %6s %8s %8s %8s %8s %10s %6s %10s %10s\n", "config", "solves",
+                "fail", "rmse,m", "p50,m", "p95,m", "p99,m", "conv,s", "nconv",
+                "cpu,us", "cpu99,us");
+    for (const auto& r : results) {
+        std::printf("%-16s %8zu %6zu %8.3f %8.3f %8.3f %8.3f %10.1f %6zu %10.2f %10.2f\n",
+                    r.name.c_str(), r.solves, r.failures, r.rmse, r.p50, r.p95, r.p99,
+                    r.convergence, r.unconverged, r.cpu_mean_us, r.cpu_p99_us);
+    }
+    return 0;
+}
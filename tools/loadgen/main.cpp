@@ -0,0 +1,227 @@
+// bacon-loadgen: синтетические объявления маяков для нагрузочных тестов.
+// direct - прямо в очереди приёма MqttClient (потолок навигатора и приёма),
+// mqtt   - JSON в топик объявлений через брокер (потолок брокера и сети).
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QList>
+#include <QPair>
+#include <QPointF>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <json.hpp>
+
+#include "config/config.h"
+#include "mqtt_connector/mqtt_client.h"
+#include "simulator/traffic_generator.h"
+
+namespace {
+
+std::string advertPayload(const message_objects::BLEBeaconState& state) {
+    nlohmann::json json_data;
+    json_data["name"] = state.name_;
+    json_data["rssi"] = state.rssi_;
+    json_data["tx_power"] = state.txPower_;
+    json_data["tag"] = state.tag_;
+    if (!state.gateway_.empty()) {
+        json_data["gateway"] = state.gateway_;
+        json_data["seq"] = state.seq_;
+    }
+    return json_data.dump();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bacon-loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Synthetic BLE advert traffic generator");
+    parser.addHelpOption();
+    parser.addOption({{"b", "beacons"}, "Beacon file (name;x;y).", "file"});
+    parser.addOption({{"t", "tags"}, "Number of simulated tags.", "n", "100"});
+    parser.addOption({{"j", "threads"}, "Generator threads.", "n",
+                      QString::number(std::max(1u, std::thread::hardware_concurrency()))});
+    parser.addOption({{"d", "duration"}, "Run time, seconds.", "s", "10"});
+    parser.addOption({"mode", "direct | mqtt.", "mode", "direct"});
+    parser.addOption({"broker", "Broker host:port for mqtt mode.", "url", "localhost:1883"});
+    parser.addOption({"topic", "Advert topic for mqtt mode.", "topic", "hakaton/board"});
+    parser.addOption({"realtime", "Pace adverts at advert_interval instead of flat out."});
+    parser.addOption({"interval", "Advert interval, seconds.", "s", "0.1"});
+    parser.addOption({"trajectory", "waypoints | circle.", "kind", "waypoints"});
+    parser.addOption({"shadowing", "Shadowing sigma, dB.", "db", "4"});
+    parser.addOption({"rician-k", "Rician K factor of multipath fading.", "k", "4"});
+    parser.addOption({"gateways", "Gateways relaying each advert.", "n", "1"});
+    parser.addOption({"seed", "Random seed.", "n", "1"});
+    parser.addOption({"freq", "Navigator ticks per second (direct mode).", "hz", "1"});
+    parser.addOption({"max-queue",
+                      "Direct mode: samples per ingest queue before generators pause until "
+                      "the next tick drains them. Bounds memory when generating flat out.",
+                      "n", "200000"});
+    parser.process(app);
+
+    if (!parser.isSet("beacons")) {
+        parser.showHelp(1);
+    }
+
+    std::vector<message_objects::BLEBeacon> beacons;
+    try {
+        beacons = ConfigReader(parser.value("beacons").toStdString()).readBeacons();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    simulator::GeneratorOptions options;
+    options.tags = parser.value("tags").toInt();
+    options.advert_interval = parser.value("interval").toDouble();
+    options.trajectory = parser.value("trajectory") == "circle"
+                             ? simulator::Trajectory::CIRCLE
+                             : simulator::Trajectory::WAYPOINTS;
+    options.radio.shadowing_sigma_db = parser.value("shadowing").toDouble();
+    options.radio.rician_k = parser.value("rician-k").toDouble();
+    options.gateways = std::max(1, parser.value("gateways").toInt());
+    options.seed = parser.value("seed").toULongLong();
+
+    const int threads = std::max(1, parser.value("threads").toInt());
+    const bool direct = parser.value("mode") != "mqtt";
+    const bool realtime = parser.isSet("realtime");
+    const auto duration = std::chrono::duration<double>(parser.value("duration").toDouble());
+    const std::string topic = parser.value("topic").toStdString();
+    // очереди разбирает только такт: без предела генераторы за секунду
+    // набивают сотни МБ строк, и замер меряет аллокатор, а не навигатор
+    const std::size_t max_queued =
+        static_cast<std::size_t>(std::max(1, parser.value("max-queue").toInt())) *
+        static_cast<std::size_t>(threads);
+
+    mqtt_connector::MqttClient client;
+    QList<QPair<QString, QPointF>> known;
+    for (const auto& beacon : beacons) {
+        known.append({QString::fromStdString(beacon.name_), QPointF(beacon.x_, beacon.y_)});
+    }
+    client.setBeacons(known);
+    client.setFreqOnChange(parser.value("freq").toFloat());
+
+    if (direct) {
+        // по очереди приёма на поток генератора: потоки не делят мьютекс
+        client.initializeReplay(static_cast<std::size_t>(threads));
+    } else {
+        mqtt_connector::ConnectionConfig config;
+        const QStringList parts = parser.value("broker").split(':');
+        config.broker_host = parts.value(0).toStdString();
+        config.broker_port = parts.value(1, "1883").toInt();
+        config.client_id = "bacon-loadgen-" + std::to_string(QCoreApplication::applicationPid());
+        client.initialize(config);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!client.isConnected() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!client.isConnected()) {
+            std::cerr << "Cannot connect to " << parser.value("broker").toStdString() << std::endl;
+            return 1;
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> generated{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> paused_us{0};
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            auto generator = simulator::TrafficGenerator::forWorker(beacons, options, w, threads);
+            const auto shard = static_cast<std::size_t>(w);
+            const auto period = std::chrono::duration<double>(options.advert_interval);
+            auto next = std::chrono::steady_clock::now();
+
+            std::uint64_t local_rejected = 0;
+            const simulator::TrafficGenerator::Sink sink =
+                direct ? simulator::TrafficGenerator::Sink(
+                             [&client, shard](const message_objects::BLEBeaconState& state) {
+                                 client.addBLEBeaconState(shard, state.name_, state);
+                             })
+                       : simulator::TrafficGenerator::Sink(
+                             [&](const message_objects::BLEBeaconState& state) {
+                                 if (!client.publish(topic, advertPayload(state))) {
+                                     ++local_rejected;
+                                 }
+                             });
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (direct && client.queuedSamples() >= max_queued) {
+                    const auto pause_start = std::chrono::steady_clock::now();
+                    while (client.queuedSamples() >= max_queued &&
+                           !stop.load(std::memory_order_relaxed)) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                    const auto paused = std::chrono::steady_clock::now() - pause_start;
+                    paused_us.fetch_add(
+                        std::chrono::duration_cast<std::chrono::microseconds>(paused).count());
+                    if (realtime) {
+                        next += paused;
+                    }
+                    continue;
+                }
+                generated.fetch_add(generator.step(sink), std::memory_order_relaxed);
+                if (realtime) {
+                    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+                    std::this_thread::sleep_until(next);
+                }
+            }
+            rejected.fetch_add(local_rejected);
+        });
+    }
+
+    // такты навигатора в direct-режиме ведёт этот поток
+    const auto start = std::chrono::steady_clock::now();
+    const auto tick = std::chrono::duration<double>(1.0 / std::max(0.001f, client.frequency()));
+    std::uint64_t positions = 0;
+    double solve_seconds = 0;
+    while (std::chrono::steady_clock::now() - start < duration) {
+        std::this_thread::sleep_for(
+            std::min(std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick),
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                         duration - (std::chrono::steady_clock::now() - start))));
+        if (direct) {
+            const auto solve_start = std::chrono::steady_clock::now();
+            positions += client.processTick(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count());
+            solve_seconds += std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - solve_start)
+                                 .count();
+        }
+    }
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "mode: " << (direct ? "direct" : "mqtt") << ", threads: " << threads
+              << ", tags: " << options.tags << ", beacons: " << beacons.size() << "\n"
+              << "samples: " << generated << " (" << generated / elapsed / 1e6
+              << " M/s)";
+    if (!direct) {
+        std::cout << ", rejected by backpressure: " << rejected;
+    }
+    std::cout << "\n";
+    if (direct) {
+        std::cout << "positions: " << positions << ", navigator time: " << solve_seconds
+                  << " s, generators paused on full queues: "
+                  << 100.0 * paused_us / 1e6 / (elapsed * threads) << "%\n";
+    }
+
+    client.shutdown();
+    return 0;
+}
@@ -0,0 +1,138 @@
+// bacon-replay: прогон записанного трафика через навигатор без брокера.
+// Позиции печатаются в stdout как "ts_ms,tag,x,y" - два прогона с разными
+// версиями навигатора можно сравнить diff'ом. --check-speed прогоняет запись
+// дважды (без пауз и в заданном темпе) и проверяет, что позиции совпали.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QList>
+#include <QPair>
+#include <QPointF>
+
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "mqtt_connector/mqtt_client.h"
+#include "recorder/replayer.h"
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bacon-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Replay recorded adverts (.blog log or gateway CSV) into the navigator");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "Advert log or CSV dump.");
+    parser.addOption({{"b", "beacons"}, "Beacon file (name;x;y).", "file"});
+    parser.addOption({{"s", "speed"},
+                      "Playback speed: 1 - original timing, N - N times faster.",
+                      "factor", "1"});
+    parser.addOption({"fast", "As fast as possible (throughput benchmark)."});
+    parser.addOption({"check-speed",
+                      "Replay as fast as possible and at this speed, fail if positions differ.",
+                      "factor"});
+    parser.addOption({"freq", "Navigator ticks per second of capture time.", "hz", "1"});
+    parser.addOption({"topic", "Topic for CSV samples.", "topic", "hakaton/board"});
+    parser.addOption({{"q", "quiet"}, "Do not print positions."});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1 || !parser.isSet("beacons")) {
+        parser.showHelp(1);
+    }
+
+    const std::string capture = parser.positionalArguments().front().toStdString();
+    const std::string topic = parser.value("topic").toStdString();
+
+    mqtt_connector::MqttClient client;
+    std::unique_ptr<recorder::SampleSource> source;
+    try {
+        QList<QPair<QString, QPointF>> beacons;
+        for (const auto& beacon :
+             ConfigReader(parser.value("beacons").toStdString()).readBeacons()) {
+            beacons.append({QString::fromStdString(beacon.name_),
+                            QPointF(beacon.x_, beacon.y_)});
+        }
+        client.setBeacons(beacons);
+        source = recorder::openSamples(capture, topic);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    client.setFreqOnChange(parser.value("freq").toFloat());
+
+    std::int64_t tick_ms = 0;
+    std::vector<std::string>* collected = nullptr;
+    const bool quiet = parser.isSet("quiet");
+    // processTick вызывается в этом же потоке, поэтому прямое соединение
+    QObject::connect(&client, &mqtt_connector::MqttClient::addPathPoint,
+                     [&](const QString& tag, const QPointF& pos) {
+                         char line[256];
+                         std::snprintf(line, sizeof(line), "%lld,%s,%.6f,%.6f",
+                                       static_cast<long long>(tick_ms),
+                                       tag.toUtf8().constData(), pos.x(), pos.y());
+                         if (collected) {
+                             collected->emplace_back(line);
+                         } else if (!quiet) {
+                             std::puts(line);
+                         }
+                     });
+
+    // каждый прогон - с чистыми навигаторами и таблицей отсева
+    const auto replay = [&](recorder::SampleSource& samples, double speed) {
+        client.initializeReplay();
+        recorder::ReplayOptions options;
+        options.speed = speed;
+        options.on_tick = [&tick_ms](std::int64_t ms) { tick_ms = ms; };
+        return recorder::Replayer(&client, options).run(samples);
+    };
+
+    if (parser.isSet("check-speed")) {
+        const double speed = parser.value("check-speed").toDouble();
+        std::vector<std::string> fast;
+        std::vector<std::string> paced;
+        collected = &fast;
+        replay(*source, 0.0);
+        collected = &paced;
+        try {
+            source = recorder::openSamples(capture, topic);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        replay(*source, speed);
+        collected = nullptr;
+
+        std::size_t first_diff = 0;
+        while (first_diff < fast.size() && first_diff < paced.size() &&
+               fast[first_diff] == paced[first_diff]) {
+            ++first_diff;
+        }
+        if (fast.size() != paced.size() || first_diff != fast.size()) {
+            std::cerr << "positions differ at line " << first_diff + 1 << ": fast "
+                      << fast.size() << " positions, speed " << speed << " "
+                      << paced.size() << " positions" << std::endl;
+            return 1;
+        }
+        std::cerr << "identical: " << fast.size() << " positions" << std::endl;
+        return 0;
+    }
+
+    const auto stats =
+        replay(*source, parser.isSet("fast") ? 0.0 : parser.value("speed").toDouble());
+
+    std::cerr << "samples: " << stats.samples << ", ticks: " << stats.ticks
+              << ", positions: " << stats.positions << "\n"
+              << "capture: " << stats.capture_seconds
+              << " s, wall: " << stats.wall_seconds << " s";
+    if (stats.wall_seconds > 0) {
+        std::cerr << ", " << stats.samples / stats.wall_seconds << " samples/s";
+    }
+    std::cerr << std::endl;
+    return 0;
+}